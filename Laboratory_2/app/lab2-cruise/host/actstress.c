@@ -0,0 +1,156 @@
+/* Host stress test of the actuator command channel
+ *
+ * Description:
+ *
+ *   Runs src/actuator.c with a producer and a consumer thread, the way
+ *   ControlTask/ButtonIO and VehicleTask use it on the board. For every
+ *   command type the producer posts bursts of commands and the consumer
+ *   polls act_read() without ever blocking. Before an ACT_FIFO burst the
+ *   producer waits until act_space() has room for all of it, so a burst
+ *   is at most ACT_FIFO_SIZE commands (larger ones are cut). At the end
+ *   it checks that
+ *
+ *   - no command was torn (value and sequence number of one post),
+ *   - ACT_FIFO: no command was lost, and commands arrived in order
+ *     without gaps and every one was read,
+ *   - ACT_LATEST: sequence numbers only increased and every command was
+ *     either read or counted as overwritten.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -pthread -I../src -o actstress actstress.c ../src/actuator.c
+ *   ./actstress [commands [burst [pause_us]]]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "actuator.h"
+
+static const struct {
+  const char* name;
+  int         kind;
+} types[ACT_NUM_CMDS] = {
+#define ACT_CMD(id, name, kind) { name, kind },
+#include "actuator_cmds.h"
+#undef ACT_CMD
+};
+
+static uint32_t commands = 1000000;
+static uint32_t burst = ACT_FIFO_SIZE;
+static uint32_t pause_us = 20;
+
+static volatile int done = 0;
+static uint32_t attempts[ACT_NUM_CMDS];
+static uint32_t errors[ACT_NUM_CMDS];
+
+static void* producer(void* arg)
+{
+  uint32_t i;
+  int id;
+
+  (void) arg;
+  for (i = 1; i <= commands; ++i) {
+    /* back-pressure: a burst only starts when the rings can take it all */
+    if ((i - 1) % burst == 0)
+      for (id = 0; id < ACT_NUM_CMDS; ++id)
+        while (act_space(id) < (types[id].kind == ACT_FIFO ? (int) burst : 1))
+          sched_yield();
+    /* the value is the attempt number, so the consumer can check it */
+    for (id = 0; id < ACT_NUM_CMDS; ++id) {
+      act_post(id, (int32_t) i);
+      attempts[id]++;
+    }
+    if (i % burst == 0 && pause_us)
+      usleep(pause_us);
+  }
+  __sync_synchronize();
+  done = 1;
+  return NULL;
+}
+
+static void check(int id, const act_cmd_t* cmd, act_cmd_t* last)
+{
+  int ok;
+
+  if (types[id].kind == ACT_LATEST)
+    ok = cmd->seq > last->seq && (uint32_t) cmd->value == cmd->seq;
+  else
+    ok = cmd->seq == last->seq + 1 && cmd->value > last->value;
+  if (!ok && errors[id]++ < 5)
+    printf("%s: seq %lu value %ld after seq %lu value %ld\n", types[id].name,
+           (unsigned long) cmd->seq, (long) cmd->value,
+           (unsigned long) last->seq, (long) last->value);
+  *last = *cmd;
+}
+
+static void* consumer(void* arg)
+{
+  act_cmd_t cmd, last[ACT_NUM_CMDS] = { { 0 } };
+  int id, stop;
+
+  (void) arg;
+  do {
+    stop = done;
+    __sync_synchronize();
+    for (id = 0; id < ACT_NUM_CMDS; ++id)
+      while (act_read(id, &cmd))
+        check(id, &cmd, &last[id]);
+  } while (!stop);
+  return NULL;
+}
+
+int main(int argc, char** argv)
+{
+  pthread_t p, c;
+  act_stats_t s;
+  int id, failed = 0;
+
+  if (argc > 1) commands = strtoul(argv[1], NULL, 0);
+  if (argc > 2) burst = strtoul(argv[2], NULL, 0);
+  if (argc > 3) pause_us = strtoul(argv[3], NULL, 0);
+  if (burst == 0) burst = 1;
+  if (burst > ACT_FIFO_SIZE) {
+    printf("bursts cut to the ring size, %d commands\n", ACT_FIFO_SIZE);
+    burst = ACT_FIFO_SIZE;
+  }
+
+  act_init();
+  pthread_create(&c, NULL, consumer, NULL);
+  pthread_create(&p, NULL, producer, NULL);
+  pthread_join(p, NULL);
+  pthread_join(c, NULL);
+
+  printf("%lu commands per type in bursts of %lu, %lu us apart\n\n",
+         (unsigned long) commands, (unsigned long) burst, (unsigned long) pause_us);
+  act_report();
+  printf("\n");
+
+  for (id = 0; id < ACT_NUM_CMDS; ++id) {
+    act_stats(id, &s);
+    if (errors[id]) {
+      printf("%s: FAIL, %lu commands out of order or torn\n", types[id].name,
+             (unsigned long) errors[id]);
+      failed = 1;
+    } else if (types[id].kind == ACT_FIFO && s.lost) {
+      printf("%s: FAIL, %lu commands lost\n", types[id].name, (unsigned long) s.lost);
+      failed = 1;
+    } else if (s.posted + s.lost != attempts[id]) {
+      printf("%s: FAIL, %lu posted + %lu lost != %lu attempts\n", types[id].name,
+             (unsigned long) s.posted, (unsigned long) s.lost, (unsigned long) attempts[id]);
+      failed = 1;
+    } else if (types[id].kind == ACT_LATEST && s.read + s.overwritten != s.posted) {
+      printf("%s: FAIL, %lu read + %lu overwritten != %lu posted\n", types[id].name,
+             (unsigned long) s.read, (unsigned long) s.overwritten, (unsigned long) s.posted);
+      failed = 1;
+    } else if (types[id].kind == ACT_FIFO && s.read != s.posted) {
+      printf("%s: FAIL, %lu read != %lu posted\n", types[id].name,
+             (unsigned long) s.read, (unsigned long) s.posted);
+      failed = 1;
+    } else {
+      printf("%s: ok\n", types[id].name);
+    }
+  }
+  return failed;
+}
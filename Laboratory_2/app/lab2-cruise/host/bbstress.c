@@ -0,0 +1,147 @@
+/* Host stress test of the vehicle state blackboard
+ *
+ * Description:
+ *
+ *   Runs src/blackboard.c with one writer thread, standing in for
+ *   VehicleTask, and several reader threads, standing in for ControlTask,
+ *   ButtonIO, SwitchIO and the display. The writer publishes snapshots
+ *   whose fields are all derived from one counter, and the readers call
+ *   blackboard_read() in a tight loop. At the end it checks that
+ *
+ *   - no snapshot was torn (all fields belong to the same publish),
+ *   - the version returned matches the snapshot that was copied,
+ *   - every reader saw versions only increase, and
+ *   - the last publish is what a final read returns.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -pthread -I../src -o bbstress bbstress.c ../src/blackboard.c
+ *   ./bbstress [publishes [readers [pause_us]]]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "blackboard.h"
+
+#define MAX_READERS 16
+
+static uint32_t publishes = 10000000;
+static int readers = 3;
+static uint32_t pause_us = 0;
+
+static volatile int done = 0;
+
+static struct {
+  pthread_t thread;
+  uint32_t  reads;
+  uint32_t  versions;  /* distinct versions seen */
+  uint32_t  torn;
+  uint32_t  backwards;
+} r[MAX_READERS];
+
+/* every field is a different function of the publish number */
+static void make_state(uint32_t n, vehicle_state_t* s)
+{
+  s->position = (int32_t) n;
+  s->velocity = (int32_t) (n * 3u + 1);
+  s->acceleration = (int32_t) ~n;
+  s->time = n;
+}
+
+static int state_ok(uint32_t v, const vehicle_state_t* s)
+{
+  vehicle_state_t ref;
+
+  make_state(v, &ref);
+  return s->position == ref.position && s->velocity == ref.velocity &&
+         s->acceleration == ref.acceleration && s->time == ref.time;
+}
+
+static void* writer(void* arg)
+{
+  vehicle_state_t s;
+  uint32_t n;
+
+  (void) arg;
+  for (n = 1; n <= publishes; ++n) {
+    make_state(n, &s);
+    blackboard_publish(&s);
+    if (pause_us)
+      usleep(pause_us);
+  }
+  __sync_synchronize();
+  done = 1;
+  return NULL;
+}
+
+static void* reader(void* arg)
+{
+  int id = (int) (intptr_t) arg;
+  vehicle_state_t s;
+  uint32_t v, last = 0;
+  int stop;
+
+  do {
+    stop = done;
+    __sync_synchronize();
+    v = blackboard_read(&s);
+    r[id].reads++;
+    /* version n is the n-th publish, so the snapshot must be number n */
+    if (v && !state_ok(v, &s) && r[id].torn++ < 5)
+      printf("reader %d: version %lu has position %ld velocity %ld time %lu\n",
+             id, (unsigned long) v, (long) s.position, (long) s.velocity,
+             (unsigned long) s.time);
+    if (v < last)
+      r[id].backwards++;
+    else if (v > last)
+      r[id].versions++;
+    last = v;
+  } while (!stop);
+  return NULL;
+}
+
+int main(int argc, char** argv)
+{
+  pthread_t w;
+  vehicle_state_t s;
+  uint32_t v;
+  int i, failed = 0;
+
+  if (argc > 1) publishes = strtoul(argv[1], NULL, 0);
+  if (argc > 2) readers = atoi(argv[2]);
+  if (argc > 3) pause_us = strtoul(argv[3], NULL, 0);
+  if (readers < 1) readers = 1;
+  if (readers > MAX_READERS) readers = MAX_READERS;
+
+  for (i = 0; i < readers; ++i)
+    pthread_create(&r[i].thread, NULL, reader, (void*) (intptr_t) i);
+  pthread_create(&w, NULL, writer, NULL);
+  pthread_join(w, NULL);
+  for (i = 0; i < readers; ++i)
+    pthread_join(r[i].thread, NULL);
+
+  printf("%lu publishes, %d readers, %lu us apart\n\n",
+         (unsigned long) publishes, readers, (unsigned long) pause_us);
+  printf("reader       reads   versions    torn  backwards\n");
+  for (i = 0; i < readers; ++i) {
+    printf("%6d %11lu %10lu %7lu %10lu\n", i, (unsigned long) r[i].reads,
+           (unsigned long) r[i].versions, (unsigned long) r[i].torn,
+           (unsigned long) r[i].backwards);
+    if (r[i].torn || r[i].backwards)
+      failed = 1;
+  }
+  printf("\n");
+
+  v = blackboard_read(&s);
+  if (failed) {
+    printf("blackboard: FAIL, torn or out of order snapshots\n");
+  } else if (v != publishes || !state_ok(v, &s)) {
+    printf("blackboard: FAIL, last read version %lu, %lu published\n",
+           (unsigned long) v, (unsigned long) publishes);
+    failed = 1;
+  } else {
+    printf("blackboard: ok\n");
+  }
+  return failed;
+}
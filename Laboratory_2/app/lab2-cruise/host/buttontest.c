@@ -0,0 +1,245 @@
+/* Host test driver of the KEY edge-capture ISR and its debouncing
+ *
+ * Description:
+ *
+ *   Runs src/buttons.c on the POSIX host port of uC/OS-II (../../posix).
+ *   A test task injects key edges through hal_keys_click(), the path the
+ *   host HAL uses for 'k' commands, so every edge sets the edge capture
+ *   register and runs the ISR as an interrupt. The edges come at chosen
+ *   tick offsets:
+ *
+ *   bounce    a press of KEY1 bouncing 1, 3, 7, 12 and 19 ms after it,
+ *   boundary  presses of KEY2 exactly BUTTON_DEBOUNCE_MS and one tick
+ *             less apart,
+ *   keys      presses of different keys and of several keys in one edge
+ *             capture, which are debounced per key,
+ *   random    random edges of random keys 0..2*BUTTON_DEBOUNCE_MS apart,
+ *   queue     more accepted presses than the event queue holds, with the
+ *             queue not drained.
+ *
+ *   For every edge the expected outcome follows from the tick of the
+ *   edge: a key is accepted if its last accepted press is at least
+ *   BUTTON_DEBOUNCE_MS ticks old. The test checks that exactly the
+ *   expected presses are posted, with their keys and tick, that nothing
+ *   else is posted, and that presses beyond the queue size are counted by
+ *   buttons_lost(). An edge is injected inside a critical section, so
+ *   the clock cannot tick between the test reading the tick and the ISR.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -pthread -I../../posix/include -I../src -o buttontest buttontest.c \
+ *       ../src/buttons.c ../src/input_trace.c ../../posix/os_posix.c ../../posix/hal_posix.c
+ *   ./buttontest [random_edges] < /dev/null
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "includes.h"
+#include "altera_avalon_pio_regs.h"
+#include "buttons.h"
+
+#define TEST_PRIO      5
+#define TEST_STACKSIZE 2048
+#define DEBOUNCE_TICKS (BUTTON_DEBOUNCE_MS * OS_TICKS_PER_SEC / 1000)
+
+static OS_STK test_stack[TEST_STACKSIZE];
+static void* queue_msgs[BUTTON_EVENTS];
+static OS_EVENT* queue;
+
+static int random_edges = 300;
+static INT32U last_accept[4];
+static long edges, accepted, errors;
+
+/* keys of 'mask' that the debouncing must accept at tick 'now' */
+static INT8U expect(INT8U mask, INT32U now)
+{
+  INT8U keys = 0;
+  int i;
+
+  for (i = 0; i < 4; ++i)
+    if ((mask & (1 << i)) && now - last_accept[i] >= DEBOUNCE_TICKS)
+      keys |= 1 << i;
+  return keys;
+}
+
+static void accept(INT8U keys, INT32U now)
+{
+  int i;
+
+  for (i = 0; i < 4; ++i)
+    if (keys & (1 << i))
+      last_accept[i] = now;
+}
+
+/*
+ * Injects one edge of 'mask'. Returns the keys expected to be accepted
+ * and the tick of the edge in 'tick'.
+ */
+static INT8U inject(INT8U mask, INT32U* tick)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  /* no clock tick between reading the tick and the ISR */
+  OS_ENTER_CRITICAL();
+  *tick = OSTimeGet();
+  hal_keys_click(mask);
+  OS_EXIT_CRITICAL();
+  edges++;
+  return expect(mask, *tick);
+}
+
+/* Injects 'mask' and checks what the ISR posted */
+static void edge(const char* name, INT8U mask)
+{
+  button_event_t* ev;
+  INT32U tick;
+  INT8U keys = inject(mask, &tick), err;
+
+  ev = (button_event_t*) OSQAccept(queue, &err);
+  if (keys) {
+    if (!ev || ev->keys != keys || ev->tick != tick) {
+      if (errors++ < 10)
+        printf("%s: keys %x at tick %lu expected, got %s %x at %lu\n", name, keys,
+               (unsigned long) tick, ev ? "keys" : "nothing", ev ? ev->keys : 0,
+               ev ? (unsigned long) ev->tick : 0ul);
+    }
+    accept(keys, tick);
+    accepted++;
+  } else if (ev) {
+    if (errors++ < 10)
+      printf("%s: edge %x at tick %lu must be ignored, got keys %x\n", name, mask,
+             (unsigned long) tick, ev->keys);
+  }
+}
+
+static void result(const char* name, long before)
+{
+  printf("%-9s %s\n", name, errors == before ? "ok" : "FAIL");
+}
+
+/* waits until 'ms' after the tick of the last accepted press of 'key' */
+static void after_press(int key, INT32U ms)
+{
+  INT32U now = OSTimeGet(), at = last_accept[key] + ms * OS_TICKS_PER_SEC / 1000;
+
+  if ((INT32S) (at - now) > 0)
+    OSTimeDly((INT16U) (at - now));
+}
+
+static void test_bounce(void)
+{
+  static const INT32U bounce[] = { 1, 3, 7, 12, 19 };
+  long before = errors;
+  unsigned int i;
+
+  OSTimeDly(2 * DEBOUNCE_TICKS);
+  edge("bounce", 0x2);
+  for (i = 0; i < sizeof(bounce) / sizeof(bounce[0]); ++i) {
+    after_press(1, bounce[i]);
+    edge("bounce", 0x2);
+  }
+  result("bounce", before);
+}
+
+static void test_boundary(void)
+{
+  long before = errors;
+  int i;
+
+  OSTimeDly(2 * DEBOUNCE_TICKS);
+  edge("boundary", 0x4);
+  for (i = 0; i < 5; ++i) {
+    after_press(2, BUTTON_DEBOUNCE_MS - 1);
+    edge("boundary", 0x4);  /* one tick early: ignored */
+    after_press(2, BUTTON_DEBOUNCE_MS);
+    edge("boundary", 0x4);  /* just in time: accepted */
+  }
+  result("boundary", before);
+}
+
+static void test_keys(void)
+{
+  long before = errors;
+
+  OSTimeDly(2 * DEBOUNCE_TICKS);
+  edge("keys", 0x1);
+  edge("keys", 0x8);        /* other key in the same tick */
+  edge("keys", 0x9);        /* both bounce */
+  OSTimeDly(5);
+  edge("keys", 0x6);        /* two fresh keys in one capture */
+  after_press(0, BUTTON_DEBOUNCE_MS);
+  edge("keys", 0xf);        /* only KEY0 and KEY3 are old enough */
+  result("keys", before);
+}
+
+static void test_random(void)
+{
+  long before = errors;
+  int i;
+
+  for (i = 0; i < random_edges; ++i) {
+    int gap = rand() % (2 * DEBOUNCE_TICKS + 1);
+
+    if (gap)
+      OSTimeDly((INT16U) gap);
+    edge("random", (INT8U) (1 + rand() % 15));
+  }
+  result("random", before);
+}
+
+static void test_queue(void)
+{
+  long before = errors;
+  INT32U lost = buttons_lost(), tick;
+  INT8U err;
+  int i, posted = 0;
+
+  OSTimeDly(2 * DEBOUNCE_TICKS);
+  for (i = 0; posted < BUTTON_EVENTS + 2; ++i) {
+    INT8U keys = inject((INT8U) (1 << (i % 4)), &tick);
+
+    accept(keys, tick);
+    if (keys)
+      posted++;
+    if (i % 4 == 3)
+      OSTimeDly(DEBOUNCE_TICKS);
+  }
+  for (i = 0; OSQAccept(queue, &err); ++i)
+    ;
+  if (i != BUTTON_EVENTS || buttons_lost() - lost != 2) {
+    printf("queue: %d presses queued and %lu lost, expected %d and 2\n", i,
+           (unsigned long) (buttons_lost() - lost), BUTTON_EVENTS);
+    errors++;
+  }
+  result("queue", before);
+}
+
+static void test_task(void* pdata)
+{
+  (void) pdata;
+  buttons_init(queue);
+  srand(1);
+
+  test_bounce();
+  test_boundary();
+  test_keys();
+  test_random();
+  test_queue();
+
+  printf("\n%ld edges, %ld presses accepted\n", edges, accepted);
+  fflush(stdout);
+  exit(errors ? 1 : 0);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1)
+    random_edges = atoi(argv[1]);
+
+  queue = OSQCreate(queue_msgs, BUTTON_EVENTS);
+  OSTaskCreateExt(test_task, NULL, &test_stack[TEST_STACKSIZE - 1], TEST_PRIO, TEST_PRIO,
+                  test_stack, TEST_STACKSIZE, NULL, OS_TASK_OPT_STK_CHK);
+  OSStart();
+  return 0;
+}
@@ -0,0 +1,615 @@
+/* Discrete-event simulation of the cruise control system in virtual time
+ *
+ * Description:
+ *
+ *   Runs the task set of src/cruise_tasks.h on a simulated fixed priority
+ *   preemptive kernel. A single thread advances a virtual clock (in us)
+ *   from one event to the next: release ticks of the dispatcher, job
+ *   completions and scripted inputs. Nothing depends on the wall clock,
+ *   so an hour of driving takes well under a second and two runs with the
+ *   same seed and script print the same report.
+ *
+ *   The model follows the target:
+ *
+ *   - Every HW_TIMER_PERIOD ms the release path runs above all tasks for
+ *     release_us and releases the timer tasks that are due, one job each.
+ *     A release that finds the previous job running is remembered once
+ *     (the flag bit of tasks.c). Any other release while a job is
+ *     pending is merged into the pending one and counted as lost.
+ *   - ButtonIO is released by scripted key presses, queued up to
+ *     BUTTON_EVENTS deep like the ISR of buttons.c does.
+ *   - A job costs its budget (wcet_us of the table, or -w) scaled by a
+ *     factor drawn uniformly from [bcet_pct, 100] % with a seeded PRNG.
+ *     ExtraLoad costs desired_utilization % of its period, up to its
+ *     budget, as load_run_limited().
+ *   - The body of a job runs when the job starts. The bodies mirror the
+ *     task code of cruise_skeleton.c and use the same vehicle model,
+ *     controller, track, blackboard and mode table (src/). Display, logging and the
+ *     monitor only cost time.
+ *   - VehicleTask reads its inputs without blocking, as on the target:
+ *     the latest throttle command (ACT_THROTTLE overwrites), the brake
+ *     and the engine message that SwitchIO sends until it is delivered.
+ *
+ *   Jitter and response times are kept with src/rtstats.c, fed with the
+ *   virtual time in ns, so the report reads like the KEY0 report of the
+ *   board. The utilisation of every MONITOR_PERIOD window is compared
+ *   with the 10 % headroom of the Monitor task.
+ *
+ *   At the end of every window the load shedding policy of the Monitor
+ *   task (src/shed.c) is applied, unless -n is given: a task held at the
+ *   current level finishes the job it has and skips its later releases
+ *   (counted as shed). ExtraLoad burns in chunks of LOAD_CHUNK_MS like
+ *   load_run_limited(): once the level rises, its running job ends with
+ *   the current chunk when suspended, or at half its budget when
+ *   throttled.
+ *
+ *   The input script has one event per line, with the commands of the
+ *   host port (app/posix) prefixed by the time in ms:
+ *
+ *     <ms> k <mask>     press the keys in <mask> (KEY0 = 1)
+ *     <ms> s <value>    set the toggle switches to <value>
+ *
+ *   Lines starting with '#' are comments. With -p every period ms prints
+ *   "T <ms> <pos> <vel> <acc> <throttle> <target> <cruise>", and -v prints
+ *   every vehicle step in the "V" format of vehicle_ref.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o cruise_sim cruise_sim.c ../src/vehicle_model.c ../src/track.c \
+ *       ../src/controller.c ../src/blackboard.c ../src/rtstats.c ../src/vehicle_mode.c \
+ *       ../src/shed.c
+ *   ./cruise_sim [-t seconds] [-s seed] [-e bcet_pct] [-r release_us]
+ *                [-w Task=wcet_us]... [-i script] [-p period_ms] [-n] [-v]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cruise_tasks.h"
+#include "vehicle_model.h"
+#include "controller.h"
+#include "blackboard.h"
+#include "vehicle_mode.h"
+#include "rtstats.h"
+#include "shed.h"
+#include "load.h"
+
+#define SIM_EVENTS 8 /* BUTTON_EVENTS of buttons.h */
+
+/* Button and switch patterns of cruise_skeleton.c */
+#define GAS_PEDAL_FLAG      0x08
+#define BRAKE_PEDAL_FLAG    0x04
+#define CRUISE_CONTROL_FLAG 0x02
+#define TOP_GEAR_FLAG       0x00000002
+#define ENGINE_FLAG         0x00000001
+#define LOAD_SWITCHES       0x000003f0 /* SW4-SW9 */
+
+#define MONITOR_HEADROOM_MIN 100 /* tenths of a percent, as cruise_skeleton.c */
+#define SHED_WINDOWS (VEHICLE_PERIOD / MONITOR_PERIOD)
+#define SHED_MARGIN  (3 * MONITOR_PERIOD / 2)
+
+typedef struct {
+  const char*   name;
+  int           prio;
+  int           release;
+  uint64_t      period;     /* us */
+  uint64_t      phase;      /* us */
+  uint32_t      wcet;       /* us */
+  int           crit;
+  /* state */
+  int           pending;    /* released jobs, including the running one */
+  int           running;    /* the first pending job has started */
+  uint64_t      cost;       /* us of the running job */
+  uint64_t      remaining;  /* us left of the running job */
+  uint64_t      next_release;
+  struct {
+    uint64_t    time;       /* us */
+    uint32_t    keys;
+  } queue[SIM_EVENTS];      /* pending jobs of an event task */
+  int           head;
+  int           shed;       /* held by the load shedding */
+  /* statistics */
+  unsigned long jobs;
+  unsigned long overruns;
+  unsigned long lost;
+  unsigned long skipped;    /* releases skipped while shed */
+  uint64_t      busy;       /* us */
+  rt_stats_t    stats;
+} sim_task_t;
+
+/* upper case parameters: the lower case ones would replace the designators */
+#define CRUISE_SIM_ROW(ID, ENTRY, PERIOD, PHASE, PRIO, STACK, WCET, RELEASE, CRIT)       \
+  { .name = #ENTRY, .prio = PRIO, .release = RELEASE, .period = (PERIOD) * 1000ull, \
+    .phase = (PHASE) * 1000ull, .wcet = WCET, .crit = CRIT },
+static sim_task_t tasks[CRUISE_NUM_TASKS] = {
+  CRUISE_TASKS(CRUISE_SIM_ROW)
+};
+#undef CRUISE_SIM_ROW
+
+typedef struct {
+  uint64_t time; /* us */
+  int      line;
+  char     cmd;
+  uint32_t value;
+} sim_input_t;
+
+static sim_input_t* inputs;
+static int num_inputs, next_input;
+
+static uint64_t now;                     /* us */
+static uint32_t release_cost = 10;       /* us per release tick */
+static uint32_t bcet_pct = 50;
+static uint64_t seed = 1, rng;
+static int trace_vehicle;
+static int shedding = 1;
+static shed_t shed;
+
+/*
+ * Application state, as the globals and task locals of cruise_skeleton.c
+ */
+static uint8_t mode;
+static int desired_utilization;
+static uint32_t switches;
+static struct {
+  int     full;
+  uint8_t value;
+} mbox_throttle, mbox_engine;
+static int engine_sent;
+static vehicle_t vehicle;
+static uint8_t vehicle_throttle, vehicle_engine;
+static uint8_t throttle, posted_throttle = 0xff;
+static int16_t target_velocity;
+static int cruise_active;
+static pi_ctrl_t pi;
+
+static sim_task_t* find(const char* name)
+{
+  int i;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+    if (strcmp(tasks[i].name, name) == 0)
+      return &tasks[i];
+  fprintf(stderr, "unknown task %s\n", name);
+  exit(1);
+}
+
+/* xorshift64*, so runs only depend on the seed */
+static uint32_t random32(void)
+{
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+  return (uint32_t) ((rng * 2685821657736338717ull) >> 32);
+}
+
+static uint32_t stamp(void)
+{
+  return (uint32_t) (now * 1000); /* ns, wraps like the timestamp timer */
+}
+
+static void mode_update(int event)
+{
+  vehicle_state_t state;
+
+  blackboard_read(&state);
+  mode = mode_next(mode, event, mode_cond(VEHICLE_INT(state.velocity)));
+}
+
+static void VehicleBody(void)
+{
+  vehicle_state_t state;
+
+  if (mbox_throttle.full) {
+    vehicle_throttle = mbox_throttle.value;
+    mbox_throttle.full = 0;
+  }
+  if (mbox_engine.full) {
+    vehicle_engine = mbox_engine.value;
+    mbox_engine.full = 0;
+  }
+  if (vehicle_throttle > 80) vehicle_throttle = 80;
+
+  vehicle_step(&vehicle, vehicle_throttle, !!(mode & MODE_BRAKE), vehicle_engine);
+  if (trace_vehicle)
+    printf("V %d %d %d %08lx %08lx %08lx\n", vehicle_throttle, !!(mode & MODE_BRAKE),
+           vehicle_engine,
+           (unsigned long) (uint32_t) vehicle.position,
+           (unsigned long) (uint32_t) vehicle.velocity,
+           (unsigned long) (uint32_t) vehicle.acceleration);
+
+  state.position = vehicle.position;
+  state.velocity = vehicle.velocity;
+  state.acceleration = vehicle.acceleration;
+  state.time = (uint32_t) (now / 1000);
+  blackboard_publish(&state);
+}
+
+static void ControlBody(void)
+{
+  vehicle_state_t state;
+  int16_t current_velocity;
+
+  blackboard_read(&state);
+  current_velocity = (int16_t) VEHICLE_INT(state.velocity);
+
+  if (!(mode & MODE_CRUISE)) {
+    if (mode & MODE_GAS)
+      target_velocity = current_velocity;
+    cruise_active = 0;
+  } else if (target_velocity >= MODE_CRUISE_MIN_VELOCITY) {
+    if (!cruise_active) {
+      pi_reset(&pi, throttle);
+      cruise_active = 1;
+    }
+    throttle = pi_step(&pi, VEHICLE_TO_Q16(target_velocity), state.velocity);
+  }
+
+  if (mode & MODE_GAS)
+    throttle = 40;
+  else if (!cruise_active && throttle > 0)
+    throttle--;
+
+  if (throttle != posted_throttle) {
+    mbox_throttle.value = throttle;
+    mbox_throttle.full = 1;
+    posted_throttle = throttle;
+  }
+}
+
+static void ButtonBody(uint32_t buttons)
+{
+  if (buttons & CRUISE_CONTROL_FLAG)
+    mode_update(MODE_EV_CRUISE);
+  if (buttons & GAS_PEDAL_FLAG)
+    mode_update(MODE_EV_GAS);
+  if (buttons & BRAKE_PEDAL_FLAG)
+    mode_update(MODE_EV_BRAKE);
+}
+
+static void SwitchBody(void)
+{
+  desired_utilization = 2 * (int) ((switches & LOAD_SWITCHES) >> 4);
+  if (desired_utilization > 100)
+    desired_utilization = 100;
+
+  if (switches & ENGINE_FLAG)
+    mode_update(MODE_EV_ENGINE_ON);
+  else if (mode & MODE_ENGINE)
+    mode_update(MODE_EV_ENGINE_OFF);
+  if (!!(mode & MODE_ENGINE) != engine_sent && !mbox_engine.full) {
+    mbox_engine.value = !!(mode & MODE_ENGINE);
+    mbox_engine.full = 1;
+    engine_sent = mbox_engine.value;
+  }
+
+  if (switches & TOP_GEAR_FLAG)
+    mode_update(MODE_EV_TOP_GEAR_ON);
+  else if (mode & MODE_TOP_GEAR)
+    mode_update(MODE_EV_TOP_GEAR_OFF);
+}
+
+/* share of its period that ExtraLoad may take now, in us (extraload_limit()) */
+static uint64_t extraload_limit(const sim_task_t* t)
+{
+  return shed_budget(shed.level, t->crit, t->wcet);
+}
+
+/* Runs the body of the job of 't' and returns its execution time */
+static uint64_t job_start(sim_task_t* t, uint32_t buttons)
+{
+  uint64_t cost = (uint64_t) t->wcet * (bcet_pct * 1000u + random32() % ((100 - bcet_pct) * 1000u + 1));
+
+  cost /= 100000;
+  switch (t - tasks) {
+  case TASK_VEHICLE:   VehicleBody(); break;
+  case TASK_CONTROL:   ControlBody(); break;
+  case TASK_BUTTONS:   ButtonBody(buttons); break;
+  case TASK_SWITCHES:  SwitchBody(); break;
+  case TASK_EXTRALOAD:
+    cost = t->period * desired_utilization / 100;
+    if (cost > extraload_limit(t))
+      cost = extraload_limit(t);
+    break;
+  }
+  return cost;
+}
+
+static void release(sim_task_t* t)
+{
+  if (t->shed && !t->pending) {
+    t->skipped++;
+    return;
+  }
+  if (t->pending && (t->pending == 2 || !t->running)) {
+    t->lost++;
+    return;
+  }
+  if (t->pending)
+    t->overruns++;
+  t->pending++;
+  rtstats_release(&t->stats, stamp());
+}
+
+static void key_press(uint32_t keys)
+{
+  sim_task_t* t = &tasks[TASK_BUTTONS];
+
+  if (t->pending == SIM_EVENTS) {
+    t->lost++;
+    return;
+  }
+  t->queue[(t->head + t->pending) % SIM_EVENTS].time = now;
+  t->queue[(t->head + t->pending) % SIM_EVENTS].keys = keys & 0xf;
+  if (t->pending++ == 0)
+    rtstats_release(&t->stats, stamp());
+}
+
+static void read_inputs(const char* file)
+{
+  char line[128];
+  unsigned long ms, value;
+  char cmd;
+  int n = 0, size = 0;
+  FILE* f = strcmp(file, "-") == 0 ? stdin : fopen(file, "r");
+
+  if (!f) {
+    perror(file);
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), f)) {
+    ++n;
+    if (line[0] == '#' || sscanf(line, "%lu %c %li", &ms, &cmd, (long*) &value) != 3)
+      continue;
+    if (cmd != 'k' && cmd != 's') {
+      fprintf(stderr, "%s:%d: unknown command %c\n", file, n, cmd);
+      exit(1);
+    }
+    if (num_inputs == size) {
+      size = size ? 2 * size : 64;
+      inputs = realloc(inputs, size * sizeof(inputs[0]));
+    }
+    inputs[num_inputs].time = ms * 1000ull;
+    inputs[num_inputs].line = n;
+    inputs[num_inputs].cmd = cmd;
+    inputs[num_inputs].value = (uint32_t) value;
+    num_inputs++;
+  }
+  if (f != stdin)
+    fclose(f);
+}
+
+static int by_time(const void* a, const void* b)
+{
+  const sim_input_t* x = a;
+  const sim_input_t* y = b;
+
+  if (x->time != y->time)
+    return x->time < y->time ? -1 : 1;
+  return x->line - y->line;
+}
+
+/* the CRIT_HIGH timer tasks whose pending job is about to miss its deadline */
+static int at_risk(void)
+{
+  int i, n = 0;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+    if (tasks[i].crit == CRIT_HIGH && tasks[i].release == RELEASE_TIMER &&
+        tasks[i].stats.waiting &&
+        stamp() - tasks[i].stats.release >= (tasks[i].period - SHED_MARGIN * 1000ull) * 1000)
+      ++n;
+  return n;
+}
+
+/* lowers the rest of a running ExtraLoad job to its limit, after the chunk in progress */
+static void extraload_cut(sim_task_t* t)
+{
+  uint64_t used, chunk = LOAD_CHUNK_MS * 1000ull, rest, limit = extraload_limit(t);
+
+  if (!t->running)
+    return;
+  used = t->cost - t->remaining;
+  rest = used % chunk ? chunk - used % chunk : 0;
+  if (limit > used && limit - used > rest)
+    rest = limit - used;
+  if (rest < t->remaining)
+    t->remaining = rest;
+}
+
+/* Monitor: applies the load shedding policy at the end of a window */
+static void shed_window(unsigned long util)
+{
+  static unsigned long history[SHED_WINDOWS];
+  static int n;
+  unsigned long sum = 0;
+  int i, risk, headroom, level;
+
+  history[n++ % SHED_WINDOWS] = util;
+  for (i = 0; i < SHED_WINDOWS && i < n; ++i)
+    sum += history[i];
+  headroom = 1000 - (int) (sum / i);
+  risk = at_risk();
+  level = shed_update(&shed, risk || headroom < MONITOR_HEADROOM_MIN,
+                      !risk && headroom >= MONITOR_HEADROOM_MIN + SHED_HYSTERESIS);
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+    tasks[i].shed = tasks[i].release == RELEASE_TIMER && shed_suspends(level, tasks[i].crit);
+  extraload_cut(&tasks[TASK_EXTRALOAD]);
+}
+
+static int by_prio(const void* a, const void* b)
+{
+  return (*(sim_task_t* const*) a)->prio - (*(sim_task_t* const*) b)->prio;
+}
+
+int main(int argc, char** argv)
+{
+  uint64_t end = 3600000000ull, tick = 0, trace_period = 0, next_trace = 0;
+  uint64_t window = MONITOR_PERIOD * 1000ull, window_end = window;
+  uint64_t window_busy = 0, isr_busy = 0, isr_total = 0, next, run;
+  unsigned long windows = 0, overloaded = 0, util, util_max = 0;
+  unsigned long shed_windows[SHED_NUM_LEVELS] = { 0 };
+  sim_task_t* ready[CRUISE_NUM_TASKS];
+  sim_task_t* t;
+  struct timespec t0, t1;
+  double wall;
+  char* eq;
+  int i;
+
+  for (i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+      end = strtoull(argv[++i], NULL, 0) * 1000000ull;
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+      seed = strtoull(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+      bcet_pct = (uint32_t) strtoul(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      release_cost = (uint32_t) strtoul(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc && (eq = strchr(argv[++i], '='))) {
+      *eq = '\0';
+      find(argv[i])->wcet = (uint32_t) strtoul(eq + 1, NULL, 0);
+    } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+      read_inputs(argv[++i]);
+    else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+      trace_period = strtoull(argv[++i], NULL, 0) * 1000ull;
+    else if (strcmp(argv[i], "-n") == 0)
+      shedding = 0;
+    else if (strcmp(argv[i], "-v") == 0)
+      trace_vehicle = 1;
+    else {
+      fprintf(stderr, "usage: %s [-t seconds] [-s seed] [-e bcet_pct] [-r release_us] "
+              "[-w Task=wcet_us]... [-i script] [-p period_ms] [-n] [-v]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (bcet_pct > 100)
+    bcet_pct = 100;
+  rng = seed ? seed : 1;
+  qsort(inputs, num_inputs, sizeof(inputs[0]), by_time);
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    ready[i] = &tasks[i];
+    tasks[i].next_release = tasks[i].phase;
+    rtstats_init(&tasks[i].stats);
+  }
+  qsort(ready, CRUISE_NUM_TASKS, sizeof(ready[0]), by_prio);
+  vehicle_init(&vehicle, VEHICLE_PERIOD);
+  pi_init(&pi, CONTROL_KP, CONTROL_KI);
+  mode_init();
+  shed_init(&shed);
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  while (now < end) {
+    /* events due now: inputs, the release tick, monitor windows, trace */
+    while (next_input < num_inputs && inputs[next_input].time <= now) {
+      if (inputs[next_input].cmd == 'k')
+        key_press(inputs[next_input].value);
+      else
+        switches = inputs[next_input].value & 0x3ffff;
+      next_input++;
+    }
+    if (now == tick) {
+      isr_busy += release_cost;
+      for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+        if (tasks[i].release == RELEASE_TIMER && tasks[i].next_release == now) {
+          release(&tasks[i]);
+          tasks[i].next_release += tasks[i].period;
+        }
+      tick += HW_TIMER_PERIOD * 1000ull;
+    }
+    if (now == window_end) {
+      util = (unsigned long) (window_busy * 1000 / window);
+      if (util > util_max) util_max = util;
+      if (1000 - util < MONITOR_HEADROOM_MIN) overloaded++;
+      if (shedding) shed_window(util);
+      shed_windows[shed.level]++;
+      windows++;
+      window_busy = 0;
+      window_end += window;
+    }
+    if (trace_period && now == next_trace) {
+      printf("T %llu %ld %ld %ld %d %d %d\n", (unsigned long long) (now / 1000),
+             (long) VEHICLE_INT(vehicle.position), (long) VEHICLE_INT(vehicle.velocity),
+             (long) VEHICLE_INT(vehicle.acceleration), vehicle_throttle,
+             target_velocity, !!(mode & MODE_CRUISE));
+      next_trace += trace_period;
+    }
+
+    next = tick < end ? tick : end;
+    if (window_end < next) next = window_end;
+    if (trace_period && next_trace < next) next = next_trace;
+    if (next_input < num_inputs && inputs[next_input].time < next)
+      next = inputs[next_input].time;
+
+    /* the release path runs first, then the highest priority job */
+    if (isr_busy) {
+      run = isr_busy < next - now ? isr_busy : next - now;
+      isr_busy -= run;
+      isr_total += run;
+      window_busy += run;
+      now += run;
+      continue;
+    }
+    for (i = 0; i < CRUISE_NUM_TASKS && !ready[i]->pending; ++i)
+      ;
+    if (i == CRUISE_NUM_TASKS) {
+      now = next;
+      continue;
+    }
+    t = ready[i];
+    if (!t->running) {
+      t->running = 1;
+      rtstats_start(&t->stats, stamp());
+      t->remaining = t->cost = job_start(t, t->queue[t->head].keys);
+    }
+    run = t->remaining < next - now ? t->remaining : next - now;
+    t->remaining -= run;
+    t->busy += run;
+    window_busy += run;
+    now += run;
+    if (t->remaining == 0) {
+      rtstats_complete(&t->stats, stamp());
+      t->running = 0;
+      t->jobs++;
+      if (t->release == RELEASE_EVENT) {
+        t->head = (t->head + 1) % SIM_EVENTS;
+        if (t->pending > 1)
+          rtstats_release(&t->stats, (uint32_t) (t->queue[t->head].time * 1000));
+      }
+      t->pending--;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  wall = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+  fprintf(stderr, "%.3f s of wall time, %.0fx real time\n", wall,
+          wall > 0 ? end / 1e6 / wall : 0.0);
+
+  printf("simulated %llu.%03llu s, seed %llu, execution %lu-100 %% of the budgets, "
+         "release overhead %lu us every %d ms\n\n",
+         (unsigned long long) (end / 1000000), (unsigned long long) (end / 1000 % 1000),
+         (unsigned long long) seed, (unsigned long) bcet_pct, (unsigned long) release_cost,
+         HW_TIMER_PERIOD);
+  printf("%-12s %4s %10s %10s %8s %8s %6s\n", "task", "prio", "jobs", "overruns", "lost",
+         "shed", "cpu %");
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    t = ready[i];
+    util = (unsigned long) (t->busy * 1000 / end);
+    printf("%-12s %4d %10lu %10lu %8lu %8lu %4lu.%lu\n", t->name, t->prio, t->jobs,
+           t->overruns, t->lost, t->skipped, util / 10, util % 10);
+  }
+  util = (unsigned long) (isr_total * 1000 / end);
+  printf("%-12s %4s %10s %10s %8s %8s %4lu.%lu\n", "release", "-", "-", "-", "-", "-",
+         util / 10, util % 10);
+  printf("\nmonitor windows %lu, max utilization %lu.%lu %%, overloaded %lu\n",
+         windows, util_max / 10, util_max % 10, overloaded);
+  if (shedding)
+    printf("load shedding: %lu switches, windows at none/throttle/suspend %lu/%lu/%lu\n",
+           (unsigned long) shed.switches, shed_windows[SHED_NONE],
+           shed_windows[SHED_THROTTLE], shed_windows[SHED_SUSPEND]);
+  printf("vehicle at %ld m, %ld m/s, throttle %d\n\n",
+         (long) VEHICLE_INT(vehicle.position), (long) VEHICLE_INT(vehicle.velocity),
+         vehicle_throttle);
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+    rtstats_print(ready[i]->name, &ready[i]->stats);
+  return 0;
+}
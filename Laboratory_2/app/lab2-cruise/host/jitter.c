@@ -0,0 +1,58 @@
+/* Host run of the release jitter and response time statistics
+ *
+ * Description:
+ *
+ *   Releases a periodic job with clock_nanosleep(TIMER_ABSTIME) and
+ *   records it with the same statistics code as the cruise tasks
+ *   (src/rtstats.c), using the clock_gettime time stamps of
+ *   src/timestamp.h. The report has the same format as the one the
+ *   target prints on KEY0, so host and board numbers can be compared.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o jitter jitter.c ../src/rtstats.c
+ *   ./jitter [period_ms [jobs [work_us]]]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rtstats.h"
+#include "timestamp.h"
+
+static void busy(uint32_t us)
+{
+  uint32_t start = timestamp_now();
+
+  while (timestamp_now() - start < us * 1000u)
+    ;
+}
+
+int main(int argc, char** argv)
+{
+  long period_ms = argc > 1 ? atol(argv[1]) : 300;
+  long jobs = argc > 2 ? atol(argv[2]) : 20;
+  uint32_t work_us = argc > 3 ? (uint32_t) atol(argv[3]) : 1000;
+  struct timespec next;
+  rt_stats_t stats;
+  long i;
+
+  rtstats_init(&stats);
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  for (i = 0; i < jobs; ++i) {
+    next.tv_nsec += (period_ms % 1000) * 1000000;
+    next.tv_sec += period_ms / 1000 + next.tv_nsec / 1000000000;
+    next.tv_nsec %= 1000000000;
+
+    rtstats_complete(&stats, timestamp_now());
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    /* nominal release time */
+    rtstats_release(&stats, (uint32_t) ((uint64_t) next.tv_sec * 1000000000u + next.tv_nsec));
+    rtstats_start(&stats, timestamp_now());
+    busy(work_us);
+  }
+  rtstats_complete(&stats, timestamp_now());
+
+  rtstats_print("host", &stats);
+  return 0;
+}
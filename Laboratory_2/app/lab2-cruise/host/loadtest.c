@@ -0,0 +1,174 @@
+/* Host accuracy test of the calibrated load generator
+ *
+ * Description:
+ *
+ *   Calibrates src/load.c with load_calibrate() and runs load_run() for
+ *   a range of percentages of an EXTRALOAD_PERIOD window. Every run is
+ *   timed with clock_gettime(CLOCK_MONOTONIC), independently of the
+ *   timestamp timer load.c uses. A percentage passes when the median
+ *   time of its runs is within the tolerance (-t, in percent of the
+ *   window, default 1) of the requested share. The CPU time of the
+ *   thread is shown as well; it falls short of the wall-clock time when
+ *   the host runs something else meanwhile.
+ *
+ *   Then load_run_limited() is checked with a limit that drops the share
+ *   of an 80% job to 30% once it has run 20% of the window: the job must
+ *   end near 30%, one LOAD_CHUNK_MS late at most.
+ *
+ *   Last, the switched-out time of the task is faked as half the time
+ *   since the start of the run: a 30% job must then take 60% of the
+ *   window and report 30%, an 80% job must end with the window and
+ *   report the 50% it burned.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o loadtest loadtest.c ../src/load.c
+ *   ./loadtest [-t tolerance] [-n runs] [-p period_ms]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cruise_tasks.h"
+#include "load.h"
+#include "timestamp.h"
+
+#define MAX_RUNS 31
+
+static double now_ms(clockid_t clock)
+{
+  struct timespec ts;
+
+  clock_gettime(clock, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int compare(const void* a, const void* b)
+{
+  double x = *(const double*) a, y = *(const double*) b;
+
+  return x < y ? -1 : x > y;
+}
+
+static double median(double* v, int n)
+{
+  qsort(v, n, sizeof(*v), compare);
+  return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+/* drops the share to 'cut_percent' once the job has run 'cut_ms' */
+static double cut_start, cut_ms;
+static uint32_t cut_percent;
+
+static uint32_t cut_limit(void)
+{
+  return now_ms(CLOCK_MONOTONIC) - cut_start >= cut_ms ? cut_percent : 100;
+}
+
+/* switched out half of the time since 'out_start' */
+static uint32_t out_start;
+
+static uint32_t half_out(void)
+{
+  return (timestamp_now() - out_start) / 2;
+}
+
+/* Checks a run with half of the time switched out, returns 1 on failure */
+static int switched_out_run(uint32_t percent, uint32_t period, int runs, double tolerance)
+{
+  double wall[MAX_RUNS], reported[MAX_RUNS], w, r, want_w, want_r;
+  double slack = tolerance + 100.0 * LOAD_CHUNK_MS / period;
+  int i, bad;
+
+  want_r = percent < 50 ? percent : 50;
+  want_w = 2 * want_r;
+  load_set_switched_out(half_out);
+  for (i = 0; i < runs; ++i) {
+    double w0 = now_ms(CLOCK_MONOTONIC);
+
+    out_start = timestamp_now();
+    reported[i] = load_run(percent, period) / 10.0;
+    wall[i] = (now_ms(CLOCK_MONOTONIC) - w0) * 100 / period;
+  }
+  load_set_switched_out(0);
+  w = median(wall, runs);
+  r = median(reported, runs);
+  bad = w < want_w - 2 * tolerance || w > want_w + 2 * slack ||
+        r < want_r - tolerance || r > want_r + slack;
+  printf("half out %2lu%%: wall %.2f%% (%.0f%%), reported %.1f%% (%.0f%%) %s\n",
+         (unsigned long) percent, w, want_w, r, want_r, bad ? "FAIL" : "ok");
+  return bad;
+}
+
+int main(int argc, char** argv)
+{
+  static const uint32_t percents[] = { 1, 5, 10, 25, 50, 75, 100 };
+  double tolerance = 1.0, wall[MAX_RUNS], cpu[MAX_RUNS], reported[MAX_RUNS];
+  double w, c, r, err, worst = 0;
+  uint32_t period = EXTRALOAD_PERIOD;
+  int runs = 5, i, k, failed = 0;
+
+  for (i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+      tolerance = atof(argv[++i]);
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      runs = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+      period = (uint32_t) atoi(argv[++i]);
+  }
+  if (runs < 1) runs = 1;
+  if (runs > MAX_RUNS) runs = MAX_RUNS;
+  if (period == 0) period = 1;
+
+  if (load_calibrate() < 0) {
+    printf("no timestamp timer\n");
+    return 1;
+  }
+  printf("%lu iterations per ms, %d runs of a %lu ms window, tolerance %.1f%%\n\n",
+         (unsigned long) load_iterations_per_ms(), runs, (unsigned long) period, tolerance);
+  printf("requested    wall %%     cpu %%  reported %%   error\n");
+
+  for (k = 0; k < (int) (sizeof(percents) / sizeof(percents[0])); ++k) {
+    for (i = 0; i < runs; ++i) {
+      double w0 = now_ms(CLOCK_MONOTONIC), c0 = now_ms(CLOCK_THREAD_CPUTIME_ID);
+
+      reported[i] = load_run(percents[k], period) / 10.0;
+      wall[i] = (now_ms(CLOCK_MONOTONIC) - w0) * 100 / period;
+      cpu[i] = (now_ms(CLOCK_THREAD_CPUTIME_ID) - c0) * 100 / period;
+    }
+    w = median(wall, runs);
+    c = median(cpu, runs);
+    r = median(reported, runs);
+    err = w - percents[k];
+    if (err < 0 ? -err > worst : err > worst)
+      worst = err < 0 ? -err : err;
+    printf("%8lu%% %9.2f %9.2f %11.1f %+7.2f %s\n", (unsigned long) percents[k], w, c, r,
+           err, err > tolerance || err < -tolerance ? "FAIL" : "ok");
+    if (err > tolerance || err < -tolerance)
+      failed = 1;
+  }
+
+  /* a job of 80% whose share drops to 30% after 20% of the window */
+  cut_percent = 30;
+  cut_ms = period * 0.2;
+  for (i = 0; i < runs; ++i) {
+    cut_start = now_ms(CLOCK_MONOTONIC);
+    load_run_limited(80, period, cut_limit);
+    wall[i] = (now_ms(CLOCK_MONOTONIC) - cut_start) * 100 / period;
+  }
+  w = median(wall, runs);
+  err = w - cut_percent;
+  printf("\nlimited  80%% cut to %lu%%: %.2f%% %s\n", (unsigned long) cut_percent, w,
+         err < -tolerance || err > tolerance + 100.0 * LOAD_CHUNK_MS / period ? "FAIL" : "ok");
+  if (err < -tolerance || err > tolerance + 100.0 * LOAD_CHUNK_MS / period)
+    failed = 1;
+
+  printf("\n");
+  if (switched_out_run(30, period, runs, tolerance))
+    failed = 1;
+  if (switched_out_run(80, period, runs, tolerance))
+    failed = 1;
+
+  printf("\nworst error %.2f%% of the window: %s\n", worst, failed ? "FAIL" : "ok");
+  return failed;
+}
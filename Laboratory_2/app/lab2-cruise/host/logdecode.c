@@ -0,0 +1,78 @@
+/* Decoder for the binary log stream of the cruise control
+ *
+ * Description:
+ *
+ *   With LOG_BINARY set to 1, LogTask writes every log record as 24 raw
+ *   bytes instead of text (see src/logger.c). This tool reads that stream,
+ *   looks up the format of each record in the same message table as the
+ *   target (src/logger_msgs.h) and prints the text the target would have
+ *   printed. Bytes that do not start a record are skipped until the next
+ *   sync word.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o logdecode logdecode.c
+ *   nios2-terminal -q --no-quit-on-ctrl-d | ./logdecode
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include "logger.h"
+
+#define RECORD_SIZE (8 + 4 * LOG_ARGS)
+
+static const char* const formats[LOG_NUM_MSGS] = {
+#define LOG_MSG(id, level, format) format,
+#include "logger_msgs.h"
+#undef LOG_MSG
+};
+
+static uint32_t get16(const uint8_t* p)
+{
+  return (uint32_t) p[0] | (uint32_t) p[1] << 8;
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+  return get16(p) | get16(p + 2) << 16;
+}
+
+int main(void)
+{
+  uint8_t buf[RECORD_SIZE];
+  size_t have = 0;
+  unsigned long records = 0, skipped = 0;
+  int c;
+
+  while ((c = getchar()) != EOF) {
+    buf[have++] = (uint8_t) c;
+
+    /* resynchronise on the sync word */
+    if (have == 2 && get16(buf) != LOG_SYNC) {
+      buf[0] = buf[1];
+      have = 1;
+      ++skipped;
+      continue;
+    }
+    if (have < RECORD_SIZE)
+      continue;
+
+    {
+      uint32_t id = get16(buf + 2);
+      int32_t a[LOG_ARGS];
+      int i;
+
+      for (i = 0; i < LOG_ARGS; ++i)
+        a[i] = (int32_t) get32(buf + 8 + 4 * i);
+      printf("[%lu] ", (unsigned long) get32(buf + 4));
+      if (id < LOG_NUM_MSGS)
+        printf(formats[id], a[0], a[1], a[2], a[3]);
+      else
+        printf("unknown log message %lu\n", (unsigned long) id);
+      ++records;
+    }
+    have = 0;
+  }
+
+  fprintf(stderr, "%lu records decoded, %lu bytes skipped\n", records, skipped);
+  return 0;
+}
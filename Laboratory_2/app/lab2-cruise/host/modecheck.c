@@ -0,0 +1,177 @@
+/* Host check of the vehicle mode table
+ *
+ * Description:
+ *
+ *   Builds the transition table of src/vehicle_mode.c and
+ *
+ *   - walks every mode reachable from the start mode (all off) under
+ *     every event and guard condition, and checks the invariants the
+ *     application relies on: cruise control is only engaged in top gear
+ *     with no pedal pressed, an engine only stops with the vehicle, a
+ *     pedal event always toggles its pedal and a repeated switch event
+ *     (engine, top gear) changes nothing;
+ *   - replays event sequences and compares every mode with the expected
+ *     one. A sequence is read from each file argument, or the built-in
+ *     drive below is replayed. One event per line:
+ *
+ *       <event> <velocity m/s> [<expected mode>]
+ *
+ *     <event> is an event name of vehicle_mode_rules.h with '_' for
+ *     blanks (e.g. top_gear_on), the mode is written as by
+ *     mode_format(), e.g. "ET--C". Lines starting with '#' are skipped.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o modecheck modecheck.c ../src/vehicle_mode.c
+ *   ./modecheck [sequence ...]
+ */
+#include <stdio.h>
+#include <string.h>
+#include "vehicle_mode.h"
+
+static const char* const drive[] = {
+  "# start the engine and accelerate in top gear",
+  "engine_on 0 E----",
+  "top_gear_on 0 ET---",
+  "cruise 0 ET---",        /* too slow to engage */
+  "gas 5 ETG--",
+  "cruise 25 ETG--",       /* not with the gas pedal pressed */
+  "gas 25 ET---",
+  "cruise 25 ET--C",
+  "# the brake disengages, cruise again and leave top gear",
+  "brake 25 ET-B-",
+  "cruise 25 ET-B-",       /* not with the brake pedal pressed */
+  "brake 22 ET---",
+  "cruise 22 ET--C",
+  "top_gear_off 22 E----",
+  "cruise 22 E----",       /* only in top gear */
+  "# the engine only stops with the vehicle",
+  "engine_off 12 E----",
+  "engine_off 0 -----",
+  NULL
+};
+
+static int failed = 0;
+
+static int parse_event(const char* word)
+{
+  char name[32];
+  int e, i;
+
+  for (e = 0; e < MODE_NUM_EVENTS; ++e) {
+    strncpy(name, mode_event_name(e), sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    for (i = 0; name[i]; ++i)
+      if (name[i] == ' ')
+        name[i] = '_';
+    if (strcmp(name, word) == 0)
+      return e;
+  }
+  return -1;
+}
+
+/* replays one line, returns the new mode */
+static uint8_t replay(const char* where, const char* line, uint8_t state)
+{
+  char word[32], expect[16], got[MODE_BITS + 1], was[MODE_BITS + 1];
+  int velocity, event, n;
+  uint8_t next;
+
+  if (line[0] == '#' || line[0] == '\n' || line[0] == '\0')
+    return state;
+  n = sscanf(line, "%31s %d %15s", word, &velocity, expect);
+  if (n < 2 || (event = parse_event(word)) < 0) {
+    printf("%s: bad line: %s\n", where, line);
+    failed = 1;
+    return state;
+  }
+  next = mode_next(state, event, mode_cond(velocity));
+  mode_format(state, was);
+  mode_format(next, got);
+  printf("%-14s %4d m/s  %s -> %s", word, velocity, was, got);
+  if (n == 3 && strcmp(expect, got) != 0) {
+    printf("  FAIL, expected %s", expect);
+    failed = 1;
+  }
+  printf("\n");
+  return next;
+}
+
+static void check_invariants(void)
+{
+  uint8_t reached[MODE_STATES] = { 0 };
+  uint8_t queue[MODE_STATES];
+  int head = 0, tail = 0, e, c, n = 0;
+  uint8_t s, t, u;
+  char a[MODE_BITS + 1], b[MODE_BITS + 1];
+
+  reached[0] = 1;
+  queue[tail++] = 0;
+  while (head < tail) {
+    s = queue[head++];
+    ++n;
+    if ((s & MODE_CRUISE) && ((s & (MODE_TOP_GEAR | MODE_GAS | MODE_BRAKE)) != MODE_TOP_GEAR)) {
+      mode_format(s, a);
+      printf("invariant: cruise control engaged in %s\n", a);
+      failed = 1;
+    }
+    for (e = 0; e < MODE_NUM_EVENTS; ++e)
+      for (c = 0; c < MODE_CONDS; ++c) {
+        t = mode_next(s, e, c);
+        if ((s & MODE_ENGINE) && !(t & MODE_ENGINE) && !(c & MODE_COND_STOPPED)) {
+          mode_format(s, a);
+          printf("invariant: %s stops the engine of %s while moving\n", mode_event_name(e), a);
+          failed = 1;
+        }
+        if ((e == MODE_EV_GAS && !((s ^ t) & MODE_GAS)) ||
+            (e == MODE_EV_BRAKE && !((s ^ t) & MODE_BRAKE))) {
+          mode_format(s, a);
+          printf("invariant: %s does not toggle its pedal in %s\n", mode_event_name(e), a);
+          failed = 1;
+        }
+        u = mode_next(t, e, c);
+        if (e != MODE_EV_GAS && e != MODE_EV_BRAKE && e != MODE_EV_CRUISE && u != t) {
+          mode_format(t, a);
+          mode_format(u, b);
+          printf("invariant: %s repeated changes %s to %s\n", mode_event_name(e), a, b);
+          failed = 1;
+        }
+        if (!reached[t]) {
+          reached[t] = 1;
+          queue[tail++] = t;
+        }
+      }
+  }
+  printf("%d of %d modes reachable, %d events x %d conditions, table %u bytes\n\n",
+         n, MODE_STATES, MODE_NUM_EVENTS, MODE_CONDS, (unsigned int) sizeof(mode_table));
+}
+
+int main(int argc, char** argv)
+{
+  char line[128];
+  uint8_t state;
+  FILE* f;
+  int i;
+
+  mode_init();
+  check_invariants();
+
+  if (argc < 2) {
+    state = 0;
+    for (i = 0; drive[i]; ++i)
+      state = replay("drive", drive[i], state);
+  }
+  for (i = 1; i < argc; ++i) {
+    if (!(f = fopen(argv[i], "r"))) {
+      perror(argv[i]);
+      return 1;
+    }
+    state = 0;
+    while (fgets(line, sizeof(line), f))
+      state = replay(argv[i], line, state);
+    fclose(f);
+  }
+
+  printf("%s\n", failed ? "FAIL" : "ok");
+  return failed;
+}
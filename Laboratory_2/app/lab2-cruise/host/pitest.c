@@ -0,0 +1,408 @@
+/* Host unit test and microbenchmark of the fixed-point PI controller
+ *
+ * Description:
+ *
+ *   Checks src/controller.c against a double precision reference of the
+ *   same control law (saturation at CONTROL_THROTTLE_MAX, conditional
+ *   integration, integrator clamped to the throttle range):
+ *
+ *   step      one pi_step from random integrator states and velocities
+ *             gives the reference output within 1 throttle unit (the Q8
+ *             error truncation) and the reference integrator within
+ *             2/256 (steps whose output is within 1/16 of a limit are
+ *             not compared, there either may decide to integrate),
+ *   loop      a closed loop with the vehicle model on the track, where
+ *             the reference keeps its own state, stays within 2 units,
+ *   windup    after a long saturation in either direction the output
+ *             leaves the limit in the same period as the reference does;
+ *             a PI without anti-windup is shown for comparison,
+ *   reset     pi_reset followed by a step at zero error keeps the
+ *             throttle (bumpless engagement), clamped to the limit.
+ *
+ *   Then it times one ControlTask period of the control law with
+ *
+ *   old       the bang-bang law the application used before the PI
+ *             controller: throttle 40 below the target, a brake post
+ *             above it, and the throttle/1.0001 decay posted every
+ *             period,
+ *   old soft  the same with the double conversions and the divide done
+ *             in integer code like the libgcc soft-float routines a Nios
+ *             II without an FPU calls,
+ *   pi        pi_step, posting the throttle only when it changes,
+ *
+ *   on the velocity trace of the closed loop, and counts the mailbox
+ *   posts per period. The host has an FPU, so "old soft" is the closer
+ *   model of the board; cycles are read with rdtsc where available.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o pitest pitest.c ../src/controller.c ../src/vehicle_model.c \
+ *       ../src/track.c -lm
+ *   ./pitest [repeats]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cruise_tasks.h"
+#include "controller.h"
+#include "vehicle_model.h"
+#include "timestamp.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define cycles() __rdtsc()
+#else
+#define cycles() 0ull
+#endif
+
+#define TARGET        40  /* m/s */
+#define START         20  /* m/s */
+#define LOOP_PERIODS  400 /* 120 s at CONTROL_PERIOD */
+
+static int failed = 0;
+
+/*
+ * Reference controller
+ */
+typedef struct {
+  double kp, ki, integ;
+  double raw;      /* output before saturation */
+  int    antiwindup; /* 0: plain PI, for comparison */
+} ref_ctrl_t;
+
+static void ref_init(ref_ctrl_t* r, int32_t kp, int32_t ki, double integ)
+{
+  r->kp = (double) kp / CONTROL_ONE;
+  r->ki = (double) ki / CONTROL_ONE;
+  r->integ = integ;
+  r->antiwindup = 1;
+}
+
+static double ref_step(ref_ctrl_t* r, double target, double measured)
+{
+  double err = target - measured;
+  double integ = r->integ + r->ki * err;
+  double out = r->kp * err + integ;
+
+  r->raw = out;
+  if (!r->antiwindup) {
+    r->integ = integ;
+    return out > CONTROL_THROTTLE_MAX ? CONTROL_THROTTLE_MAX : out < 0 ? 0 : floor(out);
+  }
+  if (out > CONTROL_THROTTLE_MAX) {
+    out = CONTROL_THROTTLE_MAX;
+    if (err > 0) integ = r->integ;
+  } else if (out < 0) {
+    out = 0;
+    if (err < 0) integ = r->integ;
+  }
+  if (integ > CONTROL_THROTTLE_MAX) integ = CONTROL_THROTTLE_MAX;
+  else if (integ < 0) integ = 0;
+  r->integ = integ;
+  return floor(out);
+}
+
+static void result(const char* name, int ok, const char* detail)
+{
+  printf("%-7s %s%s%s\n", name, ok ? "ok" : "FAIL", *detail ? ", " : "", detail);
+  if (!ok)
+    failed = 1;
+}
+
+static int32_t random_q16(int max)
+{
+  return (int32_t) (((uint32_t) rand() << 8 ^ (uint32_t) rand()) % ((uint32_t) max << 16));
+}
+
+static void test_step(void)
+{
+  pi_ctrl_t pi;
+  ref_ctrl_t ref;
+  double out_err = 0, integ_err = 0, d;
+  char detail[120];
+  int i, edge = 0;
+
+  pi_init(&pi, CONTROL_KP, CONTROL_KI);
+  for (i = 0; i < 1000000; ++i) {
+    int32_t integ = rand() % ((CONTROL_THROTTLE_MAX << CONTROL_Q) + 1);
+    int32_t target = random_q16(100), measured = random_q16(100);
+    uint8_t out;
+    double r;
+
+    pi.integ = integ;
+    ref_init(&ref, CONTROL_KP, CONTROL_KI, (double) integ / CONTROL_ONE);
+    out = pi_step(&pi, target, measured);
+    r = ref_step(&ref, (double) target / VEHICLE_ONE, (double) measured / VEHICLE_ONE);
+    d = fabs(out - r);
+    if (d > out_err) out_err = d;
+    /* within the rounding of a limit the two may decide differently
+       whether to integrate, which is not an error of either */
+    if (fabs(ref.raw) < 1.0 / 16 || fabs(ref.raw - CONTROL_THROTTLE_MAX) < 1.0 / 16) {
+      edge++;
+      continue;
+    }
+    d = fabs((double) pi.integ / CONTROL_ONE - ref.integ);
+    if (d > integ_err) integ_err = d;
+  }
+  sprintf(detail, "max output error %.0f, integrator error %.4f (%d steps at a limit)",
+          out_err, integ_err, edge);
+  result("step", out_err <= 1 && integ_err <= 2.0 / CONTROL_ONE, detail);
+}
+
+/*
+ * Closed loop with the vehicle model, fills the trace of measured
+ * velocities in whole m/s, as ControlTask used to see them
+ */
+static void test_loop(int16_t* trace)
+{
+  vehicle_t vehicle;
+  pi_ctrl_t pi;
+  ref_ctrl_t ref;
+  uint8_t throttle = START;
+  double err = 0, d;
+  char detail[80];
+  int i;
+
+  vehicle_init(&vehicle, VEHICLE_PERIOD);
+  vehicle.velocity = VEHICLE_TO_Q16(START);
+  pi_init(&pi, CONTROL_KP, CONTROL_KI);
+  pi_reset(&pi, throttle);
+  ref_init(&ref, CONTROL_KP, CONTROL_KI, throttle);
+  for (i = 0; i < LOOP_PERIODS; ++i) {
+    vehicle_step(&vehicle, throttle, 0, 1);
+    trace[i] = (int16_t) VEHICLE_INT(vehicle.velocity);
+    throttle = pi_step(&pi, VEHICLE_TO_Q16(TARGET), vehicle.velocity);
+    d = fabs(throttle - ref_step(&ref, TARGET, (double) vehicle.velocity / VEHICLE_ONE));
+    if (d > err) err = d;
+  }
+  sprintf(detail, "max output error %.0f over %d periods, end at %.1f m/s", err,
+          LOOP_PERIODS, (double) vehicle.velocity / VEHICLE_ONE);
+  result("loop", err <= 2, detail);
+}
+
+/* periods until the output leaves the limit after 'hold' saturated periods */
+static int recovery(int direction, int hold)
+{
+  pi_ctrl_t pi;
+  int32_t target = VEHICLE_TO_Q16(TARGET);
+  int32_t far = target - direction * VEHICLE_TO_Q16(20);
+  int32_t near = target + direction * VEHICLE_ONE;
+  uint8_t limit = direction > 0 ? CONTROL_THROTTLE_MAX : 0;
+  int i;
+
+  pi_init(&pi, CONTROL_KP, CONTROL_KI);
+  pi_reset(&pi, TARGET);
+  for (i = 0; i < hold; ++i)
+    if (pi_step(&pi, target, far) != limit)
+      return -1;
+  for (i = 1; i < 100000; ++i)
+    if (pi_step(&pi, target, near) != limit)
+      return i;
+  return i;
+}
+
+static int ref_recovery(int direction, int hold, int antiwindup)
+{
+  ref_ctrl_t ref;
+  double far = TARGET - direction * 20, near = TARGET + direction;
+  double limit = direction > 0 ? CONTROL_THROTTLE_MAX : 0;
+  int i;
+
+  ref_init(&ref, CONTROL_KP, CONTROL_KI, TARGET);
+  ref.antiwindup = antiwindup;
+  for (i = 0; i < hold; ++i)
+    if (ref_step(&ref, TARGET, far) != limit)
+      return -1;
+  for (i = 1; i < 100000; ++i)
+    if (ref_step(&ref, TARGET, near) != limit)
+      return i;
+  return i;
+}
+
+static void test_windup(void)
+{
+  char detail[120];
+  int direction;
+
+  for (direction = 1; direction >= -1; direction -= 2) {
+    int pi = recovery(direction, 500), ref = ref_recovery(direction, 500, 1);
+    int naive = ref_recovery(direction, 500, 0);
+
+    sprintf(detail, "%s 500 periods, leaves the limit after %d (reference %d, "
+            "without anti-windup %d)", direction > 0 ? "at 80 for" : "at 0 for",
+            pi, ref, naive);
+    result("windup", pi > 0 && pi == ref, detail);
+  }
+}
+
+static void test_reset(void)
+{
+  pi_ctrl_t pi;
+  char detail[80] = "";
+  int t, ok = 1;
+
+  pi_init(&pi, CONTROL_KP, CONTROL_KI);
+  for (t = 0; t <= 255; ++t) {
+    int expect = t > CONTROL_THROTTLE_MAX ? CONTROL_THROTTLE_MAX : t;
+    int out;
+
+    pi_reset(&pi, (uint8_t) t);
+    out = pi_step(&pi, VEHICLE_TO_Q16(TARGET), VEHICLE_TO_Q16(TARGET));
+    if (out != expect && ok) {
+      sprintf(detail, "throttle %d gives %d", t, out);
+      ok = 0;
+    }
+  }
+  result("reset", ok, detail);
+}
+
+/*
+ * Soft-float model of 'throttle = throttle / 1.0001' for positive
+ * operands, as the libgcc routines __floatunsidf, __divdf3 and
+ * __fixunsdfsi do it with integer instructions
+ */
+#define DF_MANT ((1ull << 52) - 1)
+
+static uint64_t soft_u2d(uint32_t a)
+{
+  int e = 31;
+
+  if (a == 0)
+    return 0;
+  while (!(a & 0x80000000u)) {
+    a <<= 1;
+    e--;
+  }
+  return (uint64_t) (1023 + e) << 52 | ((uint64_t) a << 21 & DF_MANT);
+}
+
+static uint64_t soft_div(uint64_t a, uint64_t b)
+{
+  int e = (int) (a >> 52) - (int) (b >> 52) + 1023, i;
+  uint64_t ma = (a & DF_MANT) | 1ull << 52, mb = (b & DF_MANT) | 1ull << 52, q = 0;
+
+  if (a == 0)
+    return 0;
+  if (ma < mb) {
+    ma <<= 1;
+    e--;
+  }
+  for (i = 0; i < 53; ++i) {  /* one quotient bit per iteration */
+    q <<= 1;
+    if (ma >= mb) {
+      ma -= mb;
+      q |= 1;
+    }
+    ma <<= 1;
+  }
+  return (uint64_t) e << 52 | (q & DF_MANT);
+}
+
+static uint32_t soft_d2u(uint64_t a)
+{
+  int e = (int) (a >> 52) - 1023;
+
+  if (e < 0)
+    return 0;
+  return (uint32_t) (((a & DF_MANT) | 1ull << 52) >> (52 - e));
+}
+
+static uint64_t decay_bits;
+
+/*
+ * One ControlTask period of each law, cruise control on and gas pedal off
+ */
+static volatile uint32_t mbox;
+static uint32_t posts;
+static uint8_t throttle;
+
+#define POST(v) (mbox = (v), posts++)
+
+static __attribute__((noinline)) void law_old(int16_t current)
+{
+  if (current - TARGET < 0) {
+    throttle = 40;
+    POST(throttle);
+  } else if (current - TARGET > 0) {
+    POST(1);  /* brake */
+  }
+  throttle = throttle / 1.0001;
+  POST(throttle);
+}
+
+static __attribute__((noinline)) void law_old_soft(int16_t current)
+{
+  if (current - TARGET < 0) {
+    throttle = 40;
+    POST(throttle);
+  } else if (current - TARGET > 0) {
+    POST(1);
+  }
+  throttle = (uint8_t) soft_d2u(soft_div(soft_u2d(throttle), decay_bits));
+  POST(throttle);
+}
+
+static pi_ctrl_t bench_pi;
+
+static __attribute__((noinline)) void law_pi(int16_t current)
+{
+  static uint8_t posted = 0xff;
+
+  throttle = pi_step(&bench_pi, VEHICLE_TO_Q16(TARGET), VEHICLE_TO_Q16(current));
+  if (throttle != posted) {
+    POST(throttle);
+    posted = throttle;
+  }
+}
+
+static void run(const char* name, void (*law)(int16_t), const int16_t* trace, int repeats)
+{
+  uint32_t t0, t1;
+  uint64_t c0, c1;
+  long n = (long) repeats * LOOP_PERIODS;
+  int i, j;
+
+  throttle = START;
+  pi_init(&bench_pi, CONTROL_KP, CONTROL_KI);
+  pi_reset(&bench_pi, throttle);
+  posts = 0;
+  c0 = cycles();
+  t0 = timestamp_now();
+  for (j = 0; j < repeats; ++j)
+    for (i = 0; i < LOOP_PERIODS; ++i)
+      law(trace[i]);
+  t1 = timestamp_now();
+  c1 = cycles();
+  printf("%-9s %8.2f ns %8.1f cycles per period, %5.2f posts per period\n", name,
+         (double) (t1 - t0) / n, (double) (c1 - c0) / n, (double) posts / n);
+}
+
+int main(int argc, char** argv)
+{
+  int16_t trace[LOOP_PERIODS];
+  double decay = 1.0001;
+  int repeats = argc > 1 ? atoi(argv[1]) : 10000, t;
+
+  if (repeats <= 0)
+    repeats = 1;
+  srand(1);
+  test_step();
+  test_loop(trace);
+  test_windup();
+  test_reset();
+
+  /* the soft-float decay must give what the FPU gives */
+  memcpy(&decay_bits, &decay, sizeof(decay_bits));
+  for (t = 0; t <= 255; ++t)
+    if (soft_d2u(soft_div(soft_u2d(t), decay_bits)) != (uint32_t) (uint8_t) (t / 1.0001)) {
+      printf("soft-float decay differs for %d\n", t);
+      return 1;
+    }
+
+  printf("\n%d periods of the closed loop, %d times\n", LOOP_PERIODS, repeats);
+  run("old", law_old, trace, repeats);
+  run("old soft", law_old_soft, trace, repeats);
+  run("pi", law_pi, trace, repeats);
+  return failed;
+}
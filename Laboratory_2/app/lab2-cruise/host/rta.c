@@ -0,0 +1,318 @@
+/* Response-time analysis of the cruise task set
+ *
+ * Description:
+ *
+ *   Reads the task set from src/cruise_tasks.h (periods, priorities and
+ *   execution budgets) and runs exact response-time analysis for fixed
+ *   priority preemptive scheduling with deadlines equal to periods:
+ *
+ *     R = n C + B + Crel * ceil(R / Trel) + sum_hp ceil(R / Tj) * nj Cj
+ *
+ *   B is the blocking term of the task: the longest section of a lower
+ *   priority task that cannot be preempted, taken from the table of
+ *   sections below. In uC/OS-II these are the kernel services (mailbox,
+ *   queue, flag and memory operations run with interrupts disabled), the
+ *   scheduler lock of mode_update() and the interrupts-off copies of the
+ *   logger, the statistics and the input trace. The lowest priority task
+ *   is never blocked. Crel is the cost of the release path, which runs
+ *   every Trel = HW_TIMER_PERIOD ms above all tasks.
+ *
+ *   n is the number of jobs a task can be released with at once, 1 but
+ *   for ButtonIO: its ISR debounces every key on its own, so each of the
+ *   BUTTON_KEYS keys can be pressed once every BUTTON_DEBOUNCE_MS, the
+ *   period of ButtonIO in the table, and all of them can queue up.
+ *
+ *   The section lengths, the release cost and the execution budgets of
+ *   cruise_tasks.h are estimates, not board measurements. Pass measured
+ *   figures with -s, -r, -w and -f; -b sets one blocking term for all
+ *   tasks instead of the per-task ones.
+ *
+ *   For every task the tool prints the worst-case response time and the
+ *   slack. Then it prints the critical scaling factor, i.e. how much all
+ *   execution budgets can grow before a deadline is missed, and the
+ *   largest budget one task (ExtraLoad by default) can have while all
+ *   deadlines are still met.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../../posix/include -I../src -o rta rta.c
+ *   ./rta [-b blocking_us] [-s section=us]... [-r release_us] [-w Task=wcet_us]...
+ *         [-f wcet_file] [-t Task]
+ *
+ *   A wcet_file has one "Task wcet_us" pair per line and overrides the
+ *   budgets of the table with measured execution times, as does -w.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cruise_tasks.h"
+#include "buttons.h"
+
+typedef struct {
+  const char*   name;
+  int           prio;
+  unsigned long period;   /* us */
+  unsigned long wcet;     /* us */
+  unsigned long jobs;     /* jobs released at once */
+  unsigned long blocking; /* us, computed from the sections */
+  const char*   blocker;  /* section giving the blocking term */
+} rta_task_t;
+
+typedef struct {
+  const char*   name;
+  const char*   tasks;  /* entries of the tasks running it, "*" for all */
+  unsigned long us;     /* estimated length on the 50 MHz Nios II */
+} rta_section_t;
+
+/* upper case parameters: the lower case ones would replace the designators */
+#define CRUISE_RTA_ROW(ID, ENTRY, PERIOD, PHASE, PRIO, STACK, WCET, RELEASE, CRIT) \
+  { .name = #ENTRY, .prio = PRIO, .period = (PERIOD) * 1000ul, .wcet = WCET, .jobs = 1 },
+static rta_task_t tasks[CRUISE_NUM_TASKS] = {
+  CRUISE_TASKS(CRUISE_RTA_ROW)
+};
+#undef CRUISE_RTA_ROW
+
+/*
+ * Sections that no higher priority task can preempt. Copies are
+ * estimated at 10 cycles per word (uncached SDRAM), kernel services from
+ * the uC/OS-II code paths.
+ */
+static rta_section_t sections[] = {
+  { "kernel",           "*",                 20 }, /* one OS service, e.g. OSFlagPost */
+  { "log_write",        "*",                  2 }, /* slot reservation in the log ring */
+  { "display_set",      "*",                  2 }, /* shadow register update */
+  { "msgpool",          "SwitchIO VehicleTask", 2 }, /* counters of msg_send/msg_free */
+  { "input_trace",      "SwitchIO",           2 }, /* one record of a switch change */
+  { "mode_update",      "ButtonIO SwitchIO", 50 }, /* OSSchedLock, two OSFlagPost */
+  { "monitor",          "Monitor",            5 }, /* idle count, tasks_at_risk() */
+  { "extraload_limit",  "ExtraLoad",          1 }, /* shed level read */
+  { "tasks_report",     "LogTask",           15 }, /* one rt_stats_t, 61 words */
+  { "release_report",   "LogTask",            2 },
+  { "input_trace_dump", "LogTask",          105 }, /* 256 records, 512 words */
+};
+#define RTA_SECTIONS (sizeof(sections) / sizeof(sections[0]))
+
+static long blocking = -1;               /* us, -1: per task from the sections */
+static unsigned long release_cost = 10;  /* us per release tick */
+static unsigned long release_period = HW_TIMER_PERIOD * 1000ul;
+
+static rta_task_t* find(const char* name)
+{
+  int i;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+    if (strcmp(tasks[i].name, name) == 0)
+      return &tasks[i];
+  fprintf(stderr, "unknown task %s\n", name);
+  exit(1);
+}
+
+static void set_wcet(const char* name, unsigned long wcet)
+{
+  find(name)->wcet = wcet;
+}
+
+static void set_section(const char* name, unsigned long us)
+{
+  unsigned int i;
+
+  for (i = 0; i < RTA_SECTIONS; ++i)
+    if (strcmp(sections[i].name, name) == 0) {
+      sections[i].us = us;
+      return;
+    }
+  fprintf(stderr, "unknown section %s\n", name);
+  exit(1);
+}
+
+/* whether 'task' is named in the space separated list 'tasks' */
+static int runs_section(const char* tasks, const char* task)
+{
+  size_t n = strlen(task);
+  const char* p;
+
+  if (strcmp(tasks, "*") == 0)
+    return 1;
+  for (p = tasks; (p = strstr(p, task)) != NULL; p += n)
+    if ((p == tasks || p[-1] == ' ') && (p[n] == ' ' || p[n] == '\0'))
+      return 1;
+  return 0;
+}
+
+/*
+ * Blocking term of every task: the longest section run by a task of
+ * lower priority
+ */
+static void compute_blocking(void)
+{
+  unsigned int s;
+  int i, j;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    tasks[i].blocking = 0;
+    tasks[i].blocker = "-";
+    if (blocking >= 0) {
+      tasks[i].blocking = (unsigned long) blocking;
+      tasks[i].blocker = "-b";
+      continue;
+    }
+    for (j = 0; j < CRUISE_NUM_TASKS; ++j) {
+      if (tasks[j].prio <= tasks[i].prio)
+        continue;
+      for (s = 0; s < RTA_SECTIONS; ++s)
+        if (sections[s].us > tasks[i].blocking && runs_section(sections[s].tasks, tasks[j].name)) {
+          tasks[i].blocking = sections[s].us;
+          tasks[i].blocker = sections[s].name;
+        }
+    }
+  }
+}
+
+static unsigned long ceil_div(unsigned long a, unsigned long b)
+{
+  return (a + b - 1) / b;
+}
+
+/*
+ * Worst-case response time of task 'i' with all budgets scaled by
+ * scale/1000000, or 0 if it exceeds the deadline.
+ */
+static unsigned long response_time(int i, unsigned long long scale)
+{
+  unsigned long c = tasks[i].jobs * (unsigned long) (tasks[i].wcet * scale / 1000000);
+  unsigned long r = c + tasks[i].blocking + release_cost;
+  unsigned long next;
+  int j;
+
+  for (;;) {
+    next = c + tasks[i].blocking + ceil_div(r, release_period) * release_cost;
+    for (j = 0; j < CRUISE_NUM_TASKS; ++j)
+      if (tasks[j].prio < tasks[i].prio)
+        next += ceil_div(r, tasks[j].period) * tasks[j].jobs *
+                (unsigned long) (tasks[j].wcet * scale / 1000000);
+    if (next > tasks[i].period)
+      return 0;
+    if (next == r)
+      return r;
+    r = next;
+  }
+}
+
+static int schedulable(unsigned long long scale)
+{
+  int i;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+    if (response_time(i, scale) == 0)
+      return 0;
+  return 1;
+}
+
+static int by_prio(const void* a, const void* b)
+{
+  return ((const rta_task_t*) a)->prio - ((const rta_task_t*) b)->prio;
+}
+
+static void read_wcets(const char* file)
+{
+  char name[64];
+  unsigned long wcet;
+  FILE* f = fopen(file, "r");
+
+  if (!f) {
+    perror(file);
+    exit(1);
+  }
+  while (fscanf(f, "%63s %lu", name, &wcet) == 2)
+    set_wcet(name, wcet);
+  fclose(f);
+}
+
+int main(int argc, char** argv)
+{
+  const char* target = "ExtraLoad";
+  unsigned long long lo, hi, mid;
+  unsigned long r, util = 0, saved;
+  rta_task_t* t;
+  char* eq;
+  int i;
+
+  for (i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+      blocking = strtol(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc && (eq = strchr(argv[++i], '='))) {
+      *eq = '\0';
+      set_section(argv[i], strtoul(eq + 1, NULL, 0));
+    }
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      release_cost = strtoul(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc && (eq = strchr(argv[++i], '='))) {
+      *eq = '\0';
+      set_wcet(argv[i], strtoul(eq + 1, NULL, 0));
+    } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+      read_wcets(argv[++i]);
+    else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+      target = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [-b blocking_us] [-s section=us]... [-r release_us] "
+              "[-w Task=wcet_us]... [-f wcet_file] [-t Task]\n", argv[0]);
+      return 1;
+    }
+  }
+  t = find(target);
+  find("ButtonIO")->jobs = BUTTON_KEYS;
+
+  qsort(tasks, CRUISE_NUM_TASKS, sizeof(tasks[0]), by_prio);
+  compute_blocking();
+
+  printf("estimated budgets and sections (-w, -f, -s for measured ones), "
+         "release overhead %lu us every %lu us\n\n", release_cost, release_period);
+  printf("%-12s %4s %10s %10s %8s %-17s %10s %10s\n", "task", "prio", "T (us)", "C (us)",
+         "B (us)", "blocked by", "R (us)", "slack");
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    r = response_time(i, 1000000);
+    util += (unsigned long) (tasks[i].jobs * tasks[i].wcet * 1000000ull / tasks[i].period);
+    if (r)
+      printf("%-12s %4d %10lu %10lu %8lu %-17s %10lu %10lu\n", tasks[i].name, tasks[i].prio,
+             tasks[i].period, tasks[i].wcet, tasks[i].blocking, tasks[i].blocker, r,
+             tasks[i].period - r);
+    else
+      printf("%-12s %4d %10lu %10lu %8lu %-17s %10s %10s\n", tasks[i].name, tasks[i].prio,
+             tasks[i].period, tasks[i].wcet, tasks[i].blocking, tasks[i].blocker, "miss", "-");
+  }
+  printf("\nutilization %lu.%lu %%\n", util / 10000, util / 1000 % 10);
+
+  /* largest scale factor (ppm) that keeps the set schedulable */
+  if (!schedulable(0)) {
+    printf("not schedulable even with zero execution times\n");
+    return 1;
+  }
+  lo = 0;
+  hi = 1000000;
+  while (schedulable(hi) && hi < 1000000000ull)
+    hi *= 2;
+  while (hi - lo > 1) {
+    mid = (lo + hi) / 2;
+    if (schedulable(mid)) lo = mid; else hi = mid;
+  }
+  printf("critical scaling factor %llu.%03llu\n", lo / 1000000, lo / 1000 % 1000);
+
+  /* largest budget of the target task, all others unchanged */
+  t = find(target);
+  saved = t->wcet;
+  lo = 0;
+  hi = t->period + 1;
+  t->wcet = 0;
+  if (!schedulable(1000000)) {
+    printf("%s: no budget left\n", target);
+    return 1;
+  }
+  while (hi - lo > 1) {
+    t->wcet = (unsigned long) ((lo + hi) / 2);
+    if (schedulable(1000000)) lo = t->wcet; else hi = t->wcet;
+  }
+  t->wcet = saved;
+  printf("%s: budget up to %llu us (%llu.%llu %% of its period)\n", target, lo,
+         lo * 100 / t->period, lo * 1000 / t->period % 10);
+  return 0;
+}
@@ -0,0 +1,160 @@
+/* Host microbenchmark of the seven-segment velocity display
+ *
+ * Description:
+ *
+ *   Compares the cost of one display update with
+ *
+ *   div       the division-based encoding the application used before
+ *             src/sevenseg.c, which wrote the register every period,
+ *   soft div  the same with the divisions done by a shift-subtract loop
+ *             like the libgcc routine a Nios II without a hardware
+ *             divider calls,
+ *   table     the lookup of src/sevenseg.c, writing only changed words.
+ *
+ *   The register write is a store to a volatile word. Every variant is
+ *   fed the same velocity trace: a drive that changes by at most 1 m/s
+ *   per update, like the vehicle, or random values with -r. The host
+ *   has a hardware divider, so "soft div" is the closer model of the
+ *   board; cycles are read with rdtsc where available.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o sevenbench sevenbench.c ../src/sevenseg.c
+ *   ./sevenbench [-r] [updates]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sevenseg.h"
+#include "timestamp.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define cycles() __rdtsc()
+#else
+#define cycles() 0ull
+#endif
+
+static volatile uint32_t hex_low;
+static uint32_t writes;
+
+/* as libgcc's __udivsi3 without a divide instruction */
+static unsigned soft_udiv(unsigned num, unsigned den)
+{
+  unsigned bit = 1, res = 0;
+
+  while (den < num && bit && !(den & 0x80000000u)) {
+    den <<= 1;
+    bit <<= 1;
+  }
+  while (bit) {
+    if (num >= den) {
+      num -= den;
+      res |= bit;
+    }
+    bit >>= 1;
+    den >>= 1;
+  }
+  return res;
+}
+
+static __attribute__((noinline)) void show_div(int velocity)
+{
+  int tmp = velocity;
+  uint32_t sign;
+
+  if (velocity < 0) {
+    sign = SEVENSEG_MINUS;
+    tmp = -tmp;
+  } else {
+    sign = sevenseg_digits[0];
+  }
+  hex_low = (uint32_t) sevenseg_digits[0] << 21 | sign << 14 |
+            (uint32_t) sevenseg_digits[tmp / 10] << 7 |
+            sevenseg_digits[tmp - (tmp / 10) * 10];
+  writes++;
+}
+
+static __attribute__((noinline)) void show_soft_div(int velocity)
+{
+  unsigned tmp = velocity < 0 ? -velocity : velocity;
+  uint32_t sign = velocity < 0 ? SEVENSEG_MINUS : sevenseg_digits[0];
+
+  hex_low = (uint32_t) sevenseg_digits[0] << 21 | sign << 14 |
+            (uint32_t) sevenseg_digits[soft_udiv(tmp, 10)] << 7 |
+            sevenseg_digits[tmp - soft_udiv(tmp, 10) * 10];
+  writes++;
+}
+
+static __attribute__((noinline)) void show_table(int velocity)
+{
+  static uint32_t shown = 0xffffffff;
+  uint32_t out = sevenseg_word(velocity);
+
+  if (out != shown) {
+    hex_low = out;
+    shown = out;
+    writes++;
+  }
+}
+
+static void run(const char* name, void (*show)(int), const int* trace, int n)
+{
+  uint32_t t0, t1;
+  uint64_t c0, c1;
+  int i;
+
+  writes = 0;
+  c0 = cycles();
+  t0 = timestamp_now();
+  for (i = 0; i < n; ++i)
+    show(trace[i]);
+  t1 = timestamp_now();
+  c1 = cycles();
+  printf("%-9s %8.2f ns %8.1f cycles per update, %9lu register writes\n", name,
+         (double) (t1 - t0) / n, (double) (c1 - c0) / n, (unsigned long) writes);
+}
+
+int main(int argc, char** argv)
+{
+  int n = 1000000, random = 0, i, v = 0;
+  int* trace;
+
+  for (i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-r") == 0)
+      random = 1;
+    else
+      n = atoi(argv[i]);
+  }
+  if (n <= 0 || !(trace = malloc(n * sizeof(*trace)))) {
+    fprintf(stderr, "bad number of updates\n");
+    return 1;
+  }
+
+  sevenseg_init();
+  srand(1);
+  for (i = 0; i < n; ++i) {
+    if (random)
+      v = rand() % 199 - 99;
+    else if (i % 4 == 0) /* a drive: the velocity changes every few periods */
+      v += (v < 90 && rand() % 3) ? 1 : -1;
+    trace[i] = v;
+  }
+
+  /* the old code has two digits (the trace stays in -99..99) and the
+     sign in HEX2, so only the two low digits are compared */
+  for (i = 0; i < n; ++i) {
+    show_div(trace[i]);
+    if ((hex_low & 0x3fff) != (sevenseg_word(trace[i]) & 0x3fff)) {
+      printf("encodings differ for %d\n", trace[i]);
+      return 1;
+    }
+  }
+
+  printf("%d updates, %s trace\n", n, random ? "random" : "drive");
+  run("div", show_div, trace, n);
+  run("soft div", show_soft_div, trace, n);
+  run("table", show_table, trace, n);
+  free(trace);
+  return 0;
+}
@@ -0,0 +1,425 @@
+/* Parallel sweep of the cruise controller gains and task periods
+ *
+ * Description:
+ *
+ *   Runs one closed-loop simulation of the vehicle model (src/vehicle_model.c)
+ *   and the PI controller (src/controller.c) for every point of a grid, or of
+ *   a random sample, of
+ *
+ *     Kp, Ki               controller gains (per control period)
+ *     control_ms           ControlTask period
+ *     vehicle_ms           VehicleTask period
+ *     start_m              start position on the track, i.e. the profile
+ *                          of the road the disturbance run is taken on
+ *
+ *   Every configuration is simulated twice, both times from steady state
+ *   at -v0 m/s (throttle v0, as on the flat): the cruise control is
+ *   engaged with the bumpless reset of ControlTask and follows a target of
+ *   -T m/s for -d s.
+ *
+ *   step         on a flat road: the car is held at 0 m, in the flat
+ *                first segment of the track, so the settling time and
+ *                the overshoot are those of the target step alone,
+ *   track        from start_m over the gradients of the track, for the
+ *                integrated error and the throttle effort.
+ *
+ *   The vehicle steps before the controller when both are due, as their
+ *   priorities give.
+ *
+ *   The runs are independent, so they are spread over a pool of threads.
+ *   Every worker owns a range of the runs and takes them from the front.
+ *   A worker that runs out steals the back half of the range of another
+ *   worker, so the load stays balanced although runs with long periods are
+ *   cheaper than runs with short ones.
+ *
+ *   The result is a CSV ranked by the settling time of the step run (into
+ *   +-b m/s of the target, -1 if never), then its overshoot, then the
+ *   integrated absolute error of the track run. Throttle effort is the
+ *   mean throttle and the total throttle variation of the track run, and
+ *   the CPU cost is the share that the budgets of cruise_tasks.h take at
+ *   the two periods.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -pthread -I../src -o sweep sweep.c ../src/vehicle_model.c ../src/track.c \
+ *       ../src/controller.c
+ *   ./sweep [-j threads] [-n samples] [-s seed] [-kp lo:hi:step] [-ki lo:hi:step]
+ *           [-c ms,...] [-p ms,...] [-x m,...] [-T target] [-v0 start] [-d seconds]
+ *           [-b band] > sweep.csv
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "cruise_tasks.h"
+#include "vehicle_model.h"
+#include "controller.h"
+
+#define MAX_VALUES 64
+
+typedef struct {
+  int n;
+  int v[MAX_VALUES];
+} value_list_t;
+
+typedef struct {
+  /* configuration */
+  int32_t  kp, ki;          /* Q8 */
+  int      control_ms;
+  int      vehicle_ms;
+  int      start_m;
+  /* result */
+  long     settling_ms;     /* step run, -1: never settled */
+  double   overshoot;       /* step run, m/s */
+  double   iae;             /* track run, m */
+  double   throttle_mean;
+  long     throttle_var;
+  double   cpu;             /* % */
+} run_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  long            lo, hi;   /* runs [lo, hi) not taken yet */
+  long            steals;
+  int             id;
+} worker_t;
+
+static run_t* runs;
+static long num_runs;
+static worker_t* workers;
+static int num_workers;
+
+static int target = 40;       /* m/s */
+static int start_velocity = 20;
+static long duration = 120;   /* s */
+static double band = 1.0;     /* m/s */
+
+typedef struct {
+  long   settling_ms;
+  double overshoot;
+  double iae;
+  long   throttle_total, throttle_n, throttle_var;
+} loop_result_t;
+
+/*
+ * Closed loop of one configuration, on the flat if 'flat' is set, else
+ * from r->start_m over the track
+ */
+static void simulate_loop(const run_t* r, int flat, loop_result_t* o)
+{
+  vehicle_t vehicle;
+  pi_ctrl_t pi;
+  int32_t measured, target_q16 = VEHICLE_TO_Q16(target);
+  uint8_t throttle = (uint8_t) start_velocity, last = throttle;
+  long t, step, end = duration * 1000;
+  double error, max_error = 0;
+
+  vehicle_init(&vehicle, (uint32_t) r->vehicle_ms);
+  vehicle.position = flat ? 0 : VEHICLE_TO_Q16(r->start_m);
+  vehicle.velocity = VEHICLE_TO_Q16(start_velocity);
+  measured = vehicle.velocity;
+  pi_init(&pi, r->kp, r->ki);
+  pi_reset(&pi, throttle);
+
+  /* time advances in steps of the gcd of the two periods */
+  step = r->control_ms;
+  for (t = r->vehicle_ms; t; ) {
+    long tmp = step % t;
+    step = t;
+    t = tmp;
+  }
+
+  memset(o, 0, sizeof(*o));
+  for (t = 0; t < end; t += step) {
+    if (t % r->vehicle_ms == 0) {
+      vehicle_step(&vehicle, throttle, 0, 1);
+      /* the first segment is flat, the position has no other effect */
+      if (flat)
+        vehicle.position = 0;
+      measured = vehicle.velocity;
+      error = (double) (measured - target_q16) / VEHICLE_ONE;
+      if (error > max_error) max_error = error;
+      if (error > band || error < -band) o->settling_ms = -1;
+      else if (o->settling_ms < 0) o->settling_ms = t;
+      o->iae += (error < 0 ? -error : error) * r->vehicle_ms / 1000.0;
+    }
+    if (t % r->control_ms == 0) {
+      throttle = pi_step(&pi, target_q16, measured);
+      o->throttle_var += throttle > last ? throttle - last : last - throttle;
+      last = throttle;
+      o->throttle_total += throttle;
+      o->throttle_n++;
+    }
+  }
+  o->overshoot = max_error;
+}
+
+static void simulate(run_t* r)
+{
+  loop_result_t step, track;
+
+  simulate_loop(r, 1, &step);
+  simulate_loop(r, 0, &track);
+  r->settling_ms = step.settling_ms;
+  r->overshoot = step.overshoot;
+  r->iae = track.iae;
+  r->throttle_var = track.throttle_var;
+  r->throttle_mean = track.throttle_n ? (double) track.throttle_total / track.throttle_n : 0;
+  r->cpu = CONTROL_WCET / (10.0 * r->control_ms) +
+           VEHICLE_WCET / (10.0 * r->vehicle_ms);
+}
+
+/*
+ * Work-stealing pool
+ */
+static long take(worker_t* w)
+{
+  long i = -1;
+
+  pthread_mutex_lock(&w->lock);
+  if (w->lo < w->hi)
+    i = w->lo++;
+  pthread_mutex_unlock(&w->lock);
+  return i;
+}
+
+/* Moves the back half of the runs of 'victim' to 'w' */
+static int steal(worker_t* w, worker_t* victim)
+{
+  long lo = 0, hi = 0, mid;
+
+  pthread_mutex_lock(&victim->lock);
+  if (victim->hi > victim->lo) {
+    mid = victim->lo + (victim->hi - victim->lo) / 2;
+    lo = mid;
+    hi = victim->hi;
+    victim->hi = mid;
+  }
+  pthread_mutex_unlock(&victim->lock);
+  if (lo == hi)
+    return 0;
+
+  pthread_mutex_lock(&w->lock);
+  w->lo = lo;
+  w->hi = hi;
+  w->steals++;
+  pthread_mutex_unlock(&w->lock);
+  return 1;
+}
+
+static void* worker(void* arg)
+{
+  worker_t* w = arg;
+  long i;
+  int k;
+
+  for (;;) {
+    while ((i = take(w)) >= 0)
+      simulate(&runs[i]);
+    for (k = 1; k < num_workers; ++k)
+      if (steal(w, &workers[(w->id + k) % num_workers]))
+        break;
+    if (k == num_workers)
+      return NULL;
+  }
+}
+
+/*
+ * Configuration
+ */
+static void parse_list(value_list_t* l, const char* s)
+{
+  char* end;
+
+  l->n = 0;
+  while (*s && l->n < MAX_VALUES) {
+    l->v[l->n++] = (int) strtol(s, &end, 0);
+    if (end == s || (*end && *end != ',')) {
+      fprintf(stderr, "bad list %s\n", s);
+      exit(1);
+    }
+    s = *end ? end + 1 : end;
+  }
+}
+
+/* "lo:hi:step" in real gain units to Q8 values */
+static void parse_range(value_list_t* l, const char* s)
+{
+  double lo, hi, step, g;
+
+  if (sscanf(s, "%lf:%lf:%lf", &lo, &hi, &step) != 3 || step <= 0) {
+    fprintf(stderr, "bad range %s\n", s);
+    exit(1);
+  }
+  l->n = 0;
+  for (g = lo; g <= hi + step / 2 && l->n < MAX_VALUES; g += step)
+    l->v[l->n++] = (int) (g * CONTROL_ONE + 0.5);
+}
+
+static uint64_t rng;
+
+static uint32_t random32(void)
+{
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+  return (uint32_t) ((rng * 2685821657736338717ull) >> 32);
+}
+
+static int pick(const value_list_t* l)
+{
+  return l->v[random32() % l->n];
+}
+
+/* uniform between the first and the last value of the list */
+static int sample(const value_list_t* l)
+{
+  int lo = l->v[0], hi = l->v[l->n - 1];
+
+  return lo + (int) (random32() % (uint32_t) (hi - lo + 1));
+}
+
+static int ranked(const void* a, const void* b)
+{
+  const run_t* x = a;
+  const run_t* y = b;
+
+  if ((x->settling_ms < 0) != (y->settling_ms < 0))
+    return x->settling_ms < 0 ? 1 : -1;
+  if (x->settling_ms != y->settling_ms)
+    return x->settling_ms < y->settling_ms ? -1 : 1;
+  if (x->overshoot != y->overshoot)
+    return x->overshoot < y->overshoot ? -1 : 1;
+  if (x->iae != y->iae)
+    return x->iae < y->iae ? -1 : 1;
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  value_list_t kp, ki, control, vehicle, start;
+  pthread_t* threads;
+  struct timespec t0, t1;
+  unsigned long long seed = 1;
+  long samples = 0, n, i, steals = 0;
+  double wall;
+  int a, b, c, d, e;
+
+  parse_range(&kp, "0.5:6:0.5");
+  parse_range(&ki, "0.125:1.5:0.125");
+  parse_list(&control, "100,200,300,500");
+  parse_list(&vehicle, "100,300");
+  parse_list(&start, "0,400,800,1200,1600,2000");
+  num_workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (a = 1; a < argc; ++a) {
+    if (strcmp(argv[a], "-j") == 0 && a + 1 < argc)
+      num_workers = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-n") == 0 && a + 1 < argc)
+      samples = atol(argv[++a]);
+    else if (strcmp(argv[a], "-s") == 0 && a + 1 < argc)
+      seed = strtoull(argv[++a], NULL, 0);
+    else if (strcmp(argv[a], "-kp") == 0 && a + 1 < argc)
+      parse_range(&kp, argv[++a]);
+    else if (strcmp(argv[a], "-ki") == 0 && a + 1 < argc)
+      parse_range(&ki, argv[++a]);
+    else if (strcmp(argv[a], "-c") == 0 && a + 1 < argc)
+      parse_list(&control, argv[++a]);
+    else if (strcmp(argv[a], "-p") == 0 && a + 1 < argc)
+      parse_list(&vehicle, argv[++a]);
+    else if (strcmp(argv[a], "-x") == 0 && a + 1 < argc)
+      parse_list(&start, argv[++a]);
+    else if (strcmp(argv[a], "-T") == 0 && a + 1 < argc)
+      target = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-v0") == 0 && a + 1 < argc)
+      start_velocity = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-d") == 0 && a + 1 < argc)
+      duration = atol(argv[++a]);
+    else if (strcmp(argv[a], "-b") == 0 && a + 1 < argc)
+      band = atof(argv[++a]);
+    else {
+      fprintf(stderr, "usage: %s [-j threads] [-n samples] [-s seed] [-kp lo:hi:step] "
+              "[-ki lo:hi:step] [-c ms,...] [-p ms,...] [-x m,...] [-T target] "
+              "[-v0 start] [-d seconds] [-b band]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (!kp.n || !ki.n || !control.n || !vehicle.n || !start.n) {
+    fprintf(stderr, "empty parameter list\n");
+    return 1;
+  }
+  for (i = 0; i < control.n; ++i)
+    if (control.v[i] <= 0) { fprintf(stderr, "bad period\n"); return 1; }
+  for (i = 0; i < vehicle.n; ++i)
+    if (vehicle.v[i] <= 0) { fprintf(stderr, "bad period\n"); return 1; }
+  if (num_workers < 1)
+    num_workers = 1;
+  track_init();
+
+  /* the grid, or 'samples' random points of the same ranges */
+  num_runs = samples ? samples : (long) kp.n * ki.n * control.n * vehicle.n * start.n;
+  runs = calloc(num_runs, sizeof(runs[0]));
+  if (!runs) {
+    perror("calloc");
+    return 1;
+  }
+  rng = seed ? seed : 1;
+  n = 0;
+  if (samples) {
+    for (n = 0; n < samples; ++n) {
+      runs[n].kp = sample(&kp);
+      runs[n].ki = sample(&ki);
+      runs[n].control_ms = pick(&control);
+      runs[n].vehicle_ms = pick(&vehicle);
+      runs[n].start_m = pick(&start);
+    }
+  } else {
+    for (a = 0; a < kp.n; ++a)
+      for (b = 0; b < ki.n; ++b)
+        for (c = 0; c < control.n; ++c)
+          for (d = 0; d < vehicle.n; ++d)
+            for (e = 0; e < start.n; ++e, ++n) {
+              runs[n].kp = kp.v[a];
+              runs[n].ki = ki.v[b];
+              runs[n].control_ms = control.v[c];
+              runs[n].vehicle_ms = vehicle.v[d];
+              runs[n].start_m = start.v[e];
+            }
+  }
+
+  workers = calloc(num_workers, sizeof(workers[0]));
+  threads = calloc(num_workers, sizeof(threads[0]));
+  for (i = 0; i < num_workers; ++i) {
+    pthread_mutex_init(&workers[i].lock, NULL);
+    workers[i].id = (int) i;
+    workers[i].lo = num_runs * i / num_workers;
+    workers[i].hi = num_runs * (i + 1) / num_workers;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i = 1; i < num_workers; ++i)
+    pthread_create(&threads[i], NULL, worker, &workers[i]);
+  worker(&workers[0]);
+  for (i = 1; i < num_workers; ++i)
+    pthread_join(threads[i], NULL);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  wall = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+  for (i = 0; i < num_workers; ++i)
+    steals += workers[i].steals;
+  fprintf(stderr, "%ld runs on %d threads in %.3f s (%.0f runs/s, %ld steals)\n",
+          num_runs, num_workers, wall, wall > 0 ? num_runs / wall : 0.0, steals);
+
+  qsort(runs, num_runs, sizeof(runs[0]), ranked);
+  printf("rank,kp,ki,control_ms,vehicle_ms,start_m,settling_ms,overshoot,iae,"
+         "throttle_mean,throttle_var,cpu_pct\n");
+  for (i = 0; i < num_runs; ++i)
+    printf("%ld,%.3f,%.3f,%d,%d,%d,%ld,%.2f,%.1f,%.1f,%ld,%.3f\n", i + 1,
+           (double) runs[i].kp / CONTROL_ONE, (double) runs[i].ki / CONTROL_ONE,
+           runs[i].control_ms, runs[i].vehicle_ms, runs[i].start_m,
+           runs[i].settling_ms, runs[i].overshoot, runs[i].iae,
+           runs[i].throttle_mean, runs[i].throttle_var, runs[i].cpu);
+  return 0;
+}
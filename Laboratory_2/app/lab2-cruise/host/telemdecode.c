@@ -0,0 +1,118 @@
+/* Decoder for the binary telemetry of the cruise control
+ *
+ * Description:
+ *
+ *   With TELEMETRY set to 1, VehicleTask packs its state into CRC
+ *   checked frames that LogTask writes to the JTAG UART (see
+ *   src/telemetry.h). This tool reads the UART stream, finds the frames
+ *   by their sync word and CRC and prints one CSV line per sample:
+ *
+ *     tick,position,velocity,acceleration,throttle,target,mode
+ *
+ *   The acceleration is derived from consecutive velocities, the mode is
+ *   written as by mode_format() (src/vehicle_mode.h). Any other bytes,
+ *   e.g. log text, are skipped. At the end it reports to stderr the
+ *   frames decoded, the frames dropped on the target (gaps in the frame
+ *   numbers), sync words rejected by the CRC (damaged frames, or text
+ *   that happens to contain the sync word, e.g. "OS_TMR") and the frame
+ *   bytes per sample.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o telemdecode telemdecode.c ../src/telemetry.c ../src/vehicle_mode.c
+ *   nios2-terminal -q --no-quit-on-ctrl-d | ./telemdecode > drive.csv
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "telemetry.h"
+#include "vehicle_mode.h"
+
+static uint32_t get16(const uint8_t* p)
+{
+  return (uint32_t) p[0] | (uint32_t) p[1] << 8;
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+  return get16(p) | get16(p + 2) << 16;
+}
+
+static unsigned long frames = 0, dropped = 0, crc_errors = 0, skipped = 0;
+
+static void decode(const uint8_t* f)
+{
+  static double last_velocity = 0, last_tick = 0;
+  static int have_last = 0;
+  uint32_t tick = get32(f + 4), period = get16(f + 8);
+  int target = (int16_t) get16(f + 10);
+  const uint8_t* s;
+  double velocity, accel, t;
+  uint32_t ctrl;
+  char mode[MODE_BITS + 1];
+  int i;
+
+  for (i = 0; i < TELEM_SAMPLES; ++i) {
+    s = f + TELEM_HEADER_SIZE + i * TELEM_SAMPLE_SIZE;
+    t = (double) tick + (double) i * period;
+    velocity = (int16_t) get16(s + 2) / 256.0;
+    ctrl = get16(s + 4);
+    accel = have_last && t > last_tick ? (velocity - last_velocity) * 1000.0 / (t - last_tick) : 0;
+    mode_format((uint8_t) (ctrl >> TELEM_MODE_SHIFT), mode);
+    printf("%.0f,%lu,%.3f,%.3f,%lu,%d,%s\n", t, (unsigned long) get16(s), velocity, accel,
+           (unsigned long) (ctrl & TELEM_THROTTLE_MASK), target, mode);
+    last_velocity = velocity;
+    last_tick = t;
+    have_last = 1;
+  }
+}
+
+int main(void)
+{
+  uint8_t buf[TELEM_FRAME_SIZE];
+  size_t have = 0;
+  uint32_t seq, next_seq = 0;
+  int c;
+
+  printf("tick,position,velocity,acceleration,throttle,target,mode\n");
+  while ((c = getchar()) != EOF) {
+    buf[have++] = (uint8_t) c;
+
+    /* look for the sync word */
+    if (have == 2 && get16(buf) != TELEM_SYNC) {
+      buf[0] = buf[1];
+      have = 1;
+      ++skipped;
+      continue;
+    }
+    if (have < TELEM_FRAME_SIZE)
+      continue;
+
+    if (telem_crc(buf + 2, TELEM_FRAME_SIZE - 4) != get16(buf + TELEM_FRAME_SIZE - 2)) {
+      /* not a frame, or a damaged one: resume the search after the sync */
+      ++crc_errors;
+      memmove(buf, buf + 2, TELEM_FRAME_SIZE - 2);
+      have = TELEM_FRAME_SIZE - 2;
+      skipped += 2;
+      while (have >= 2 && get16(buf) != TELEM_SYNC) {
+        memmove(buf, buf + 1, --have);
+        ++skipped;
+      }
+      continue;
+    }
+
+    seq = get16(buf + 2);
+    if (frames)
+      dropped += (uint16_t) (seq - next_seq);
+    next_seq = (seq + 1) & 0xffff;
+    ++frames;
+    decode(buf);
+    have = 0;
+  }
+
+  fprintf(stderr, "%lu frames (%lu samples), %lu dropped, %lu syncs failed the CRC, "
+          "%lu other bytes skipped\n", frames, frames * TELEM_SAMPLES, dropped,
+          crc_errors, skipped);
+  fprintf(stderr, "%.2f frame bytes per sample\n", (double) TELEM_FRAME_SIZE / TELEM_SAMPLES);
+  return 0;
+}
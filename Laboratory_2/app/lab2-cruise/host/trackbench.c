@@ -0,0 +1,158 @@
+/* Host microbenchmark of the track segment lookup
+ *
+ * Description:
+ *
+ *   Compares the cost of finding the segment of a position with
+ *
+ *   chain     a linear search over the segment starts, which is what the
+ *             if/else chain the application used before src/track.c
+ *             compiles to, one compare per segment passed,
+ *   index     the grid index of src/track.c: one shift and two loads,
+ *
+ *   on generated tracks of 6 up to 256 segments of 240 m (the index holds
+ *   a byte per segment number). Every track is driven from start to end
+ *   in 1 m steps, or at random positions with -r. The two lookups must
+ *   agree on every position. The last line times track_gradient() of
+ *   src/track.c on the real track. Cycles are read with rdtsc where
+ *   available.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o trackbench trackbench.c ../src/track.c
+ *   ./trackbench [-r] [passes]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "track.h"
+#include "timestamp.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define cycles() __rdtsc()
+#else
+#define cycles() 0ull
+#endif
+
+#define SEGMENT_LENGTH 240 /* m, 256 of them still fit the 16 bit starts */
+#define MAX_SEGMENTS   256
+
+static track_segment_t segs[MAX_SEGMENTS];
+static int num_segs;
+static int32_t length;
+static uint8_t* index_cells;
+static volatile int32_t sink;
+
+static void make_track(int n)
+{
+  int i;
+  uint32_t cell, seg = 0, cells;
+
+  num_segs = n;
+  length = n * SEGMENT_LENGTH;
+  for (i = 0; i < n; ++i) {
+    segs[i].start = (uint16_t) (i * SEGMENT_LENGTH);
+    segs[i].gradient = (int8_t) (i % 5 - 2);
+    segs[i].led = (uint8_t) (17 - i % 18);
+  }
+  /* the same expansion as track_init() */
+  cells = (length >> TRACK_GRID_SHIFT) + 1;
+  free(index_cells);
+  index_cells = malloc(cells);
+  for (cell = 0; cell < cells; ++cell) {
+    while (seg + 1 < (uint32_t) n && (cell << TRACK_GRID_SHIFT) >= segs[seg + 1].start)
+      ++seg;
+    index_cells[cell] = (uint8_t) seg;
+  }
+}
+
+static __attribute__((noinline)) int32_t gradient_chain(int32_t position)
+{
+  int i;
+
+  if (position < 0 || position > length)
+    return 0;
+  for (i = num_segs - 1; i > 0 && position < segs[i].start; --i)
+    ;
+  return segs[i].gradient;
+}
+
+static __attribute__((noinline)) int32_t gradient_index(int32_t position)
+{
+  if (position < 0 || position > length)
+    return 0;
+  return segs[index_cells[position >> TRACK_GRID_SHIFT]].gradient;
+}
+
+static double run(int32_t (*lookup)(int32_t), const int32_t* trace, int n, int passes,
+                  double* ns)
+{
+  uint32_t t0, t1;
+  uint64_t c0, c1;
+  int i, j;
+
+  c0 = cycles();
+  t0 = timestamp_now();
+  for (j = 0; j < passes; ++j)
+    for (i = 0; i < n; ++i)
+      sink = lookup(trace[i]);
+  t1 = timestamp_now();
+  c1 = cycles();
+  *ns = (double) (t1 - t0) / ((double) n * passes);
+  return (double) (c1 - c0) / ((double) n * passes);
+}
+
+static int32_t* make_trace(int32_t len, int random, int* n)
+{
+  int32_t* trace;
+  int i;
+
+  *n = len + 1;
+  trace = malloc(*n * sizeof(*trace));
+  for (i = 0; i < *n; ++i)
+    trace[i] = random ? rand() % (len + 1) : i;
+  return trace;
+}
+
+int main(int argc, char** argv)
+{
+  static const int sizes[] = { 6, 16, 64, 128, 256 };
+  int passes = 50, random = 0, i, k, n;
+  int32_t* trace;
+  double ns_chain, ns_index, cy_chain, cy_index;
+
+  for (i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-r") == 0)
+      random = 1;
+    else
+      passes = atoi(argv[i]);
+  }
+  if (passes <= 0)
+    passes = 1;
+  srand(1);
+
+  printf("%s positions, %d passes per track\n\n", random ? "random" : "driven", passes);
+  printf("segments   chain ns  cycles   index ns  cycles\n");
+  for (k = 0; k < (int) (sizeof(sizes) / sizeof(sizes[0])); ++k) {
+    make_track(sizes[k]);
+    trace = make_trace(length, random, &n);
+    for (i = 0; i < n; ++i)
+      if (gradient_chain(trace[i]) != gradient_index(trace[i])) {
+        printf("lookups differ at %ld m on %d segments\n", (long) trace[i], sizes[k]);
+        return 1;
+      }
+    cy_chain = run(gradient_chain, trace, n, passes, &ns_chain);
+    cy_index = run(gradient_index, trace, n, passes, &ns_index);
+    printf("%8d %10.2f %7.1f %10.2f %7.1f\n", sizes[k], ns_chain, cy_chain,
+           ns_index, cy_index);
+    free(trace);
+  }
+
+  track_init();
+  trace = make_trace(TRACK_LENGTH, random, &n);
+  cy_index = run(track_gradient, trace, n, passes, &ns_index);
+  printf("\ntrack.c  %d m: %.2f ns %.1f cycles per track_gradient()\n", TRACK_LENGTH,
+         ns_index, cy_index);
+  free(trace);
+  return 0;
+}
@@ -0,0 +1,91 @@
+/* Host reference model of the cruise control vehicle
+ *
+ * Description:
+ *
+ *   Runs the same vehicle_step() as VehicleTask (src/vehicle_model.c) on the
+ *   host. It reads lines from stdin in one of two forms:
+ *
+ *     <steps> <throttle> <brake> <engine>     scripted drive segment
+ *     V <throttle> <brake> <engine> <pos> <vel> <acc>
+ *                                             step printed by the target
+ *                                             with VEHICLE_TRACE set
+ *
+ *   Scripted segments are expanded and printed in the target trace format,
+ *   so a host run can be diffed against a board run. Target trace lines are
+ *   replayed and every state is compared bit for bit with the host result;
+ *   the first mismatch and the summary are printed on stderr. The period
+ *   is VEHICLE_PERIOD of the task table unless -p is given.
+ *
+ * Build and use:
+ *
+ *   gcc -O2 -I../src -o vehicle_ref vehicle_ref.c ../src/vehicle_model.c ../src/track.c
+ *   ./vehicle_ref [-p period_ms] < drive.txt
+ *   nios2-terminal | grep '^V ' | ./vehicle_ref
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cruise_tasks.h"
+#include "vehicle_model.h"
+
+static void print_step(FILE* f, const vehicle_t* v, int throttle, int brake, int engine)
+{
+  fprintf(f, "V %d %d %d %08lx %08lx %08lx\n", throttle, brake, engine,
+         (unsigned long) (uint32_t) v->position,
+         (unsigned long) (uint32_t) v->velocity,
+         (unsigned long) (uint32_t) v->acceleration);
+}
+
+int main(int argc, char** argv)
+{
+  char line[256];
+  vehicle_t vehicle;
+  unsigned long period = VEHICLE_PERIOD;
+  unsigned long steps = 0, checked = 0, mismatches = 0;
+
+  if (argc == 3 && strcmp(argv[1], "-p") == 0) {
+    period = strtoul(argv[2], NULL, 10);
+  } else if (argc != 1) {
+    fprintf(stderr, "usage: %s [-p period_ms] < input\n", argv[0]);
+    return 2;
+  }
+  vehicle_init(&vehicle, period);
+
+  while (fgets(line, sizeof(line), stdin)) {
+    int throttle, brake, engine;
+    unsigned long n, pos, vel, acc;
+
+    if (line[0] == 'V') {
+      if (sscanf(line, "V %d %d %d %lx %lx %lx", &throttle, &brake, &engine,
+                 &pos, &vel, &acc) != 6)
+        continue;
+      vehicle_step(&vehicle, (uint8_t) throttle, brake, engine);
+      ++steps;
+      ++checked;
+      if ((uint32_t) vehicle.position != pos ||
+          (uint32_t) vehicle.velocity != vel ||
+          (uint32_t) vehicle.acceleration != acc) {
+        if (mismatches++ == 0) {
+          fprintf(stderr, "first mismatch at step %lu\n  target: %s  host:   ", steps, line);
+          print_step(stderr, &vehicle, throttle, brake, engine);
+        }
+        /* continue from the target state to find further divergences */
+        vehicle.position = (int32_t) pos;
+        vehicle.velocity = (int32_t) vel;
+        vehicle.acceleration = (int32_t) acc;
+      }
+    } else if (sscanf(line, "%lu %d %d %d", &n, &throttle, &brake, &engine) == 4) {
+      while (n--) {
+        vehicle_step(&vehicle, (uint8_t) throttle, brake, engine);
+        ++steps;
+        print_step(stdout, &vehicle, throttle, brake, engine);
+      }
+    }
+  }
+
+  if (checked) {
+    fprintf(stderr, "%lu steps checked, %lu mismatches\n", checked, mismatches);
+    return mismatches ? 1 : 0;
+  }
+  return 0;
+}
@@ -0,0 +1,31 @@
+#!/bin/bash
+# @file: run-host.sh
+#
+# Builds the cruise control application against the POSIX host port of
+# uC/OS-II and the DE2 hardware (../posix) and runs it on this machine,
+# with no board attached. Arguments are passed to the program.
+#
+# Board inputs are read from stdin, one command per line:
+#   k <mask>    press the keys in <mask> (KEY0 = 1, KEY1 = 2, ...)
+#   s <value>   set the toggle switches
+#   q           quit
+#
+# Environment: UCOS_RUN_MS=<ms> stops the run after <ms> ms,
+#              HAL_TRACE=1 prints every LED and display change,
+#              HAL_COUNT=1 prints the PIO reads and writes at exit,
+#              CFLAGS adds compiler flags (e.g. -DINPUT_REPLAY=1).
+
+APP_NAME=cruise
+POSIX_PATH=../posix
+SRC_PATH=./src
+
+mkdir -p bin
+
+SOURCES=$(ls $SRC_PATH/*.c | grep -v cruise_skeleton_original.c)
+
+gcc -O2 -g -Wall -pthread $CFLAGS \
+    -I$POSIX_PATH/include -I$SRC_PATH \
+    -o bin/$APP_NAME-host \
+    $SOURCES $POSIX_PATH/*.c || exit 1
+
+./bin/$APP_NAME-host "$@"
@@ -43,6 +43,7 @@ nios2-bsp ucosii ../bsp ../$CORE_FILE \
 	  --cpu-name $CPU_NAME \
 	  --default_sections_mapping sram \
 	  --set hal.sys_clk_timer timer_0 \
+	  --set hal.timestamp_timer timer_1 \
 	  --set hal.make.bsp_cflags_debug -g \
 	  --set hal.make.bsp_cflags_optimization -Os \
 	  --set hal.enable_sopc_sysid_check 1 \
@@ -0,0 +1,154 @@
+/*
+ * Actuator command channel (see actuator.h).
+ *
+ * The writer of a type owns 'head' and the posted/lost counters, the
+ * reader owns 'tail' and the read/overwritten/age counters, so no
+ * counter has two writers.
+ */
+#include <stdio.h>
+#include "actuator.h"
+#include "timestamp.h"
+
+#define barrier() __sync_synchronize()
+
+#define ACT_MASK (ACT_FIFO_SIZE - 1)
+
+typedef char act_fifo_check[(ACT_FIFO_SIZE & ACT_MASK) == 0 ? 1 : -1];
+
+static const struct {
+  const char* name;
+  int         kind;
+} act_types[ACT_NUM_CMDS] = {
+#define ACT_CMD(id, name, kind) { name, kind },
+#include "actuator_cmds.h"
+#undef ACT_CMD
+};
+
+typedef struct {
+  volatile act_cmd_t slot[ACT_FIFO_SIZE]; /* ACT_LATEST uses two */
+  volatile uint32_t  head;  /* commands posted (ACT_LATEST: version) */
+  volatile uint32_t  tail;  /* commands read (ACT_LATEST: last version read) */
+  act_stats_t        stats;
+} act_channel_t;
+
+static act_channel_t channels[ACT_NUM_CMDS];
+
+static void copy_cmd(act_cmd_t* to, volatile const act_cmd_t* from)
+{
+  to->value = from->value;
+  to->seq = from->seq;
+  to->stamp = from->stamp;
+}
+
+void act_init(void)
+{
+  int i;
+
+  for (i = 0; i < ACT_NUM_CMDS; ++i) {
+    channels[i].head = 0;
+    channels[i].tail = 0;
+    channels[i].stats.posted = 0;
+    channels[i].stats.read = 0;
+    channels[i].stats.overwritten = 0;
+    channels[i].stats.lost = 0;
+    channels[i].stats.max_age = 0;
+  }
+}
+
+/*
+ * Posts a command of type 'id'. Returns 0, or -1 if it was lost.
+ */
+int act_post(int id, int32_t value)
+{
+  act_channel_t* c = &channels[id];
+  uint32_t next = c->head + 1;
+  volatile act_cmd_t* s;
+
+  if (act_types[id].kind == ACT_LATEST) {
+    s = &c->slot[next & 1];
+  } else {
+    if (c->head - c->tail >= ACT_FIFO_SIZE) {
+      c->stats.lost++;
+      return -1;
+    }
+    s = &c->slot[c->head & ACT_MASK];
+  }
+  s->value = value;
+  s->seq = ++c->stats.posted;
+  s->stamp = timestamp_now();
+  barrier();
+  c->head = next;
+  return 0;
+}
+
+/*
+ * Copies the next command of type 'id' into 'cmd' and returns 1, or
+ * returns 0 if there is none.
+ */
+int act_read(int id, act_cmd_t* cmd)
+{
+  act_channel_t* c = &channels[id];
+  uint32_t v, age;
+
+  if (act_types[id].kind == ACT_LATEST) {
+    do {
+      v = c->head;
+      if (v == c->tail)
+        return 0;
+      barrier();
+      copy_cmd(cmd, &c->slot[v & 1]);
+      barrier();
+    } while (v != c->head);
+    c->stats.overwritten += v - c->tail - 1;
+    c->tail = v;
+  } else {
+    v = c->tail;
+    if (v == c->head)
+      return 0;
+    barrier();
+    copy_cmd(cmd, &c->slot[v & ACT_MASK]);
+    barrier();
+    c->tail = v + 1;
+  }
+
+  c->stats.read++;
+  age = timestamp_now() - cmd->stamp;
+  if (age > c->stats.max_age)
+    c->stats.max_age = age;
+  return 1;
+}
+
+/*
+ * Returns how many commands of type 'id' the writer can post now without
+ * losing one (ACT_LATEST: always 1, a newer command only overwrites).
+ */
+int act_space(int id)
+{
+  act_channel_t* c = &channels[id];
+
+  if (act_types[id].kind == ACT_LATEST)
+    return 1;
+  return ACT_FIFO_SIZE - (int) (c->head - c->tail);
+}
+
+void act_stats(int id, act_stats_t* stats)
+{
+  *stats = channels[id].stats;
+}
+
+void act_report(void)
+{
+  uint32_t per_us = timestamp_freq() / 1000000;
+  const act_stats_t* s;
+  int i;
+
+  printf("%-10s %10s %10s %11s %6s %10s\n", "command", "posted", "read",
+         "overwritten", "lost", "max age us");
+  for (i = 0; i < ACT_NUM_CMDS; ++i) {
+    s = &channels[i].stats;
+    printf("%-10s %10lu %10lu %11lu %6lu %10lu\n", act_types[i].name,
+           (unsigned long) s->posted, (unsigned long) s->read,
+           (unsigned long) s->overwritten, (unsigned long) s->lost,
+           (unsigned long) (per_us ? s->max_age / per_us : s->max_age));
+  }
+}
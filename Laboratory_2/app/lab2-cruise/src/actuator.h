@@ -0,0 +1,57 @@
+#ifndef ACTUATOR_H_
+#define ACTUATOR_H_
+
+#include <stdint.h>
+
+/*
+ * Command channel to the actuators of the vehicle.
+ *
+ * Every command type of actuator_cmds.h has one writer task and one
+ * reader (VehicleTask). Commands carry their value, a sequence number
+ * per type and the time stamp of issue. Neither side ever blocks or
+ * disables interrupts:
+ *
+ * - ACT_LATEST types are a versioned double buffer, like the blackboard.
+ *   The reader gets the newest command once; commands it never saw are
+ *   counted as overwritten.
+ * - ACT_FIFO types are a single-producer single-consumer ring of
+ *   ACT_FIFO_SIZE commands. The reader gets every command in order;
+ *   commands posted into a full ring are counted as lost.
+ *
+ * act_read() returns at once, with 0 if there is no new command. A writer
+ * that must not lose a burst checks act_space() first.
+ */
+
+#define ACT_LATEST    0
+#define ACT_FIFO      1
+#define ACT_FIFO_SIZE 8 /* commands, power of two */
+
+enum act_cmd_id {
+#define ACT_CMD(id, name, kind) id,
+#include "actuator_cmds.h"
+#undef ACT_CMD
+  ACT_NUM_CMDS
+};
+
+typedef struct {
+  int32_t  value;
+  uint32_t seq;    /* per command type, from 1 */
+  uint32_t stamp;  /* timestamp_now() at issue */
+} act_cmd_t;
+
+typedef struct {
+  uint32_t posted;
+  uint32_t read;
+  uint32_t overwritten; /* ACT_LATEST: replaced before being read */
+  uint32_t lost;        /* ACT_FIFO: rejected, ring full */
+  uint32_t max_age;     /* time stamp ticks from issue to read */
+} act_stats_t;
+
+void act_init(void);
+int  act_post(int id, int32_t value);
+int  act_read(int id, act_cmd_t* cmd);
+int  act_space(int id);
+void act_stats(int id, act_stats_t* stats);
+void act_report(void);
+
+#endif /*ACTUATOR_H_*/
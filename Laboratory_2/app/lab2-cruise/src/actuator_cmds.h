@@ -0,0 +1,12 @@
+/*
+ * Actuator commands sent from the control side to VehicleTask.
+ *
+ * ACT_CMD(id, name, kind)
+ *
+ * ACT_LATEST  only the newest value matters, a newer command replaces an
+ *             unread one (counted as overwritten)
+ * ACT_FIFO    every command is delivered in order, a command that finds
+ *             the queue full is rejected (counted as lost)
+ */
+ACT_CMD(ACT_THROTTLE, "throttle", ACT_LATEST)
+ACT_CMD(ACT_BRAKE,    "brake",    ACT_FIFO)
@@ -0,0 +1,52 @@
+/*
+ * uC/OS-II application hooks.
+ *
+ * With OS_APP_HOOKS_EN set, the hooks of the port (os_cpu_c.c) call these
+ * functions. The idle hook counts the passes of the idle task for the
+ * utilisation monitor (see monitor.h), the task switch hook counts the
+ * preemptions of every task for the profiling sections (see prof.h).
+ *
+ * Without the hooks every monitor window reads as idle, which silently
+ * turns off the overload detection and the load shedding of Monitor, so
+ * the build fails instead.
+ */
+#include "includes.h"
+#include "monitor.h"
+#include "prof.h"
+
+#if !OS_APP_HOOKS_EN
+#error "OS_APP_HOOKS_EN must be set in the BSP: the utilisation monitor needs the idle hook"
+#endif
+
+void App_TaskCreateHook(OS_TCB* ptcb)
+{
+  (void) ptcb;
+}
+
+void App_TaskDelHook(OS_TCB* ptcb)
+{
+  (void) ptcb;
+}
+
+void App_TaskIdleHook(void)
+{
+  monitor_idle();
+}
+
+void App_TaskStatHook(void)
+{
+}
+
+void App_TaskSwHook(void)
+{
+  prof_task_switch();
+}
+
+void App_TCBInitHook(OS_TCB* ptcb)
+{
+  (void) ptcb;
+}
+
+void App_TimeTickHook(void)
+{
+}
@@ -0,0 +1,58 @@
+/*
+ * Versioned snapshot of the vehicle state.
+ *
+ * Two buffers are used: version n lives in slot (n & 1), and the writer
+ * always fills the slot that is not being published. A reader copies the
+ * slot of the version it saw and accepts the copy if the version is still
+ * the same afterwards, otherwise the writer may have started reusing the
+ * slot and the read is repeated.
+ *
+ * Because the writer never touches the published slot, a reader that
+ * preempts the writer always gets a consistent copy on the first try, and
+ * a writer that preempts a reader can only force one extra attempt. So
+ * this cannot livelock under fixed-priority scheduling, which a single
+ * buffer seqlock can when the reader has the higher priority.
+ */
+#include "blackboard.h"
+
+#define barrier() __sync_synchronize()
+
+static volatile vehicle_state_t slot[2];
+static volatile uint32_t version = 0;
+
+void blackboard_publish(const vehicle_state_t* state)
+{
+  uint32_t next = version + 1;
+  volatile vehicle_state_t* s = &slot[next & 1];
+
+  s->position = state->position;
+  s->velocity = state->velocity;
+  s->acceleration = state->acceleration;
+  s->time = state->time;
+  barrier();
+  version = next;
+}
+
+/*
+ * Copies the latest snapshot into 'state' and returns its version
+ * (0 until the first publish).
+ */
+uint32_t blackboard_read(vehicle_state_t* state)
+{
+  uint32_t v;
+
+  do {
+    volatile vehicle_state_t* s;
+
+    v = version;
+    barrier();
+    s = &slot[v & 1];
+    state->position = s->position;
+    state->velocity = s->velocity;
+    state->acceleration = s->acceleration;
+    state->time = s->time;
+    barrier();
+  } while (v != version);
+
+  return v;
+}
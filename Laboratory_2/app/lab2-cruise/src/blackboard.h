@@ -0,0 +1,24 @@
+#ifndef BLACKBOARD_H_
+#define BLACKBOARD_H_
+
+#include <stdint.h>
+
+/*
+ * Latest-value store ("blackboard") for the vehicle state.
+ *
+ * There is a single writer (VehicleTask) and any number of readers. A
+ * read never blocks: it copies the most recent snapshot and retries only
+ * if the writer published a new one in the meantime.
+ */
+
+typedef struct {
+  int32_t  position;     /* m, Q16.16 */
+  int32_t  velocity;     /* m/s, Q16.16 */
+  int32_t  acceleration; /* m/s2, Q16.16 */
+  uint32_t time;         /* OS tick of the vehicle step */
+} vehicle_state_t;
+
+void     blackboard_publish(const vehicle_state_t* state);
+uint32_t blackboard_read(vehicle_state_t* state);
+
+#endif /*BLACKBOARD_H_*/
@@ -0,0 +1,91 @@
+/*
+ * Edge-capture ISR for the KEY PIO.
+ *
+ * Events are stored in a small static ring and a pointer to the slot is
+ * posted with OSQPost(). The HAL brackets the ISR with OSIntEnter() and
+ * OSIntExit(), so a task pending on the queue is made ready on ISR exit,
+ * and the press latency is bounded by the ISR and the task dispatch.
+ */
+#include "system.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_irq.h"
+#include "buttons.h"
+#include "input_trace.h"
+#include "timestamp.h"
+
+#define KEYS_MASK 0xf
+
+static OS_EVENT* button_queue;
+/* one more slot than the queue holds, so the slot of the event a task
+ * is still handling is never reused before its next OSQPend() */
+static button_event_t events[BUTTON_EVENTS + 1];
+static int next_event = 0;
+static INT32U last_press[BUTTON_KEYS]; /* tick of the last accepted press per key */
+static INT32U lost = 0;
+
+static void buttons_isr(void* context, alt_u32 id)
+{
+  INT32U now = OSTimeGet();
+  INT8U edges = IORD_ALTERA_AVALON_PIO_EDGE_CAP(D2_PIO_KEYS4_BASE) & KEYS_MASK;
+  INT8U keys = 0;
+  int i;
+
+  (void) context;
+  (void) id;
+
+  /* Write to the edge capture register to reset it. */
+  IOWR_ALTERA_AVALON_PIO_EDGE_CAP(D2_PIO_KEYS4_BASE, 0);
+
+  for (i = 0; i < BUTTON_KEYS; ++i) {
+    if ((edges & (1 << i)) &&
+        now - last_press[i] >= BUTTON_DEBOUNCE_MS * OS_TICKS_PER_SEC / 1000) {
+      last_press[i] = now;
+      keys |= 1 << i;
+    }
+  }
+
+  if (keys)
+    buttons_post(keys);
+}
+
+/*
+ * Posts a press of 'keys' as the ISR does. Only called from interrupt
+ * context: the KEY ISR or the input replay alarm.
+ */
+void buttons_post(INT8U keys)
+{
+  button_event_t* ev = &events[next_event];
+
+  input_trace_keys(keys);
+  ev->keys = keys;
+  ev->tick = OSTimeGet();
+  ev->stamp = timestamp_now();
+  if (OSQPost(button_queue, (void*) ev) == OS_NO_ERR)
+    next_event = (next_event + 1) % (BUTTON_EVENTS + 1);
+  else
+    ++lost;
+}
+
+void buttons_init(OS_EVENT* queue)
+{
+  int i;
+
+  button_queue = queue;
+  for (i = 0; i < BUTTON_KEYS; ++i)
+    last_press[i] = OSTimeGet() - BUTTON_DEBOUNCE_MS * OS_TICKS_PER_SEC / 1000;
+
+  /* Reset the edge capture register. */
+  IOWR_ALTERA_AVALON_PIO_EDGE_CAP(D2_PIO_KEYS4_BASE, 0);
+  // Register the ISR for buttons
+  alt_irq_register(D2_PIO_KEYS4_IRQ, NULL, buttons_isr);
+  /* set interrupt capability for the Button PIO. */
+  IOWR_ALTERA_AVALON_PIO_IRQ_MASK(D2_PIO_KEYS4_BASE, KEYS_MASK);
+}
+
+/*
+ * Number of presses lost because the event queue was full
+ */
+INT32U buttons_lost(void)
+{
+  return lost;
+}
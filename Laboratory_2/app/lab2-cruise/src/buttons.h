@@ -0,0 +1,29 @@
+#ifndef BUTTONS_H_
+#define BUTTONS_H_
+
+#include "includes.h"
+
+/*
+ * Interrupt driven push buttons.
+ *
+ * The KEY PIO captures falling edges (key presses). Its ISR debounces
+ * them and posts one button_event_t per accepted press into the queue
+ * passed to buttons_init(). The event stays valid until the receiving
+ * task pends on the queue again.
+ */
+
+#define BUTTON_EVENTS      8  /* size of the event queue */
+#define BUTTON_DEBOUNCE_MS 20 /* ignore bounces of the same key */
+#define BUTTON_KEYS        4  /* KEY0..KEY3, debounced one by one */
+
+typedef struct {
+  INT8U  keys;   /* pressed keys, KEY0 = bit 0 */
+  INT32U tick;   /* OS tick of the press */
+  INT32U stamp;  /* timestamp timer value of the press */
+} button_event_t;
+
+void   buttons_init(OS_EVENT* queue);
+void   buttons_post(INT8U keys);
+INT32U buttons_lost(void);
+
+#endif /*BUTTONS_H_*/
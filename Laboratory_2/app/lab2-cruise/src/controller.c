@@ -0,0 +1,50 @@
+/*
+ * Fixed-point PI controller for the cruise control.
+ *
+ * The output is saturated to [0, CONTROL_THROTTLE_MAX]. Anti-windup is
+ * done by conditional integration: the integrator is only updated when
+ * doing so does not push the output further into saturation, and it is
+ * itself clamped to the throttle range.
+ */
+#include "controller.h"
+
+#define THROTTLE_MAX_Q8 ((int32_t) CONTROL_THROTTLE_MAX << CONTROL_Q)
+
+void pi_init(pi_ctrl_t* pi, int32_t kp, int32_t ki)
+{
+  pi->kp = kp;
+  pi->ki = ki;
+  pi->integ = 0;
+}
+
+/*
+ * Preloads the integrator with the current throttle so that engaging the
+ * cruise control does not cause a bump in the actuation.
+ */
+void pi_reset(pi_ctrl_t* pi, uint8_t throttle)
+{
+  if (throttle > CONTROL_THROTTLE_MAX)
+    throttle = CONTROL_THROTTLE_MAX;
+  pi->integ = (int32_t) throttle << CONTROL_Q;
+}
+
+uint8_t pi_step(pi_ctrl_t* pi, int32_t target_q16, int32_t measured_q16)
+{
+  int32_t err = (target_q16 - measured_q16) >> (16 - CONTROL_Q); /* m/s, Q8 */
+  int32_t integ = pi->integ + ((pi->ki * err) >> CONTROL_Q);
+  int32_t out = ((pi->kp * err) >> CONTROL_Q) + integ;
+
+  if (out > THROTTLE_MAX_Q8) {
+    out = THROTTLE_MAX_Q8;
+    if (err > 0) integ = pi->integ; // do not wind up further
+  } else if (out < 0) {
+    out = 0;
+    if (err < 0) integ = pi->integ;
+  }
+
+  if (integ > THROTTLE_MAX_Q8) integ = THROTTLE_MAX_Q8;
+  else if (integ < 0) integ = 0;
+  pi->integ = integ;
+
+  return (uint8_t) (out >> CONTROL_Q);
+}
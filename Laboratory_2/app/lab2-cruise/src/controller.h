@@ -0,0 +1,34 @@
+#ifndef CONTROLLER_H_
+#define CONTROLLER_H_
+
+#include <stdint.h>
+
+/*
+ * Fixed-point PI cruise controller.
+ *
+ * Velocities are passed in Q16.16 m/s. Internally the error is reduced
+ * to Q8 and the integrator is kept in Q8 throttle units, so a step costs
+ * a few integer multiplies and shifts and no soft-float calls.
+ */
+
+#define CONTROL_Q         8
+#define CONTROL_ONE       (1 << CONTROL_Q)
+
+/* vehicle cannot effort more than 80 units of throttle */
+#define CONTROL_THROTTLE_MAX 80
+
+/* Gains in Q8 (per control period): Kp = 3.0, Ki = 0.75 */
+#define CONTROL_KP        (3 * CONTROL_ONE)
+#define CONTROL_KI        (3 * CONTROL_ONE / 4)
+
+typedef struct {
+  int32_t kp;       /* proportional gain, Q8 */
+  int32_t ki;       /* integral gain per step, Q8 */
+  int32_t integ;    /* integrator state, Q8 throttle units */
+} pi_ctrl_t;
+
+void    pi_init(pi_ctrl_t* pi, int32_t kp, int32_t ki);
+void    pi_reset(pi_ctrl_t* pi, uint8_t throttle);
+uint8_t pi_step(pi_ctrl_t* pi, int32_t target_q16, int32_t measured_q16);
+
+#endif /*CONTROLLER_H_*/
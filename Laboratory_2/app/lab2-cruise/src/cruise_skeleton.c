@@ -13,6 +13,8 @@
  *   the real time concepts necessary for all implemented herein and also with Sw/Hw
  *   interactions that includes HAL calls and IO interactions.
  *
+ *   The periodic tasks do not print directly: they push binary records into
+ *   the log ring (logger.c), which the lowest priority LogTask formats.
  *   If the prints prove themselves too heavy for the final code, they can
  *   be exchanged for alt_printf where hexadecimals are supported and also
  *   quite readable. This modification is easily motivated and accepted by the course
@@ -25,15 +27,35 @@
 //#include "altera_avalon_performance_counter.h"
 #include "sys/alt_irq.h"
 #include "sys/alt_alarm.h"
+#include "controller.h"
+#include "vehicle_model.h"
+#include "track.h"
+#include "blackboard.h"
+#include "display.h"
+#include "load.h"
+#include "timestamp.h"
+#include "monitor.h"
+#include "logger.h"
+#include "buttons.h"
+#include "input_trace.h"
+#include "msgpool.h"
+#include "actuator.h"
+#include "vehicle_mode.h"
+#include "sevenseg.h"
+#include "telemetry.h"
+#include "shed.h"
+#include "tasks.h"
+#include "stacks.h"
+#include "prof.h"
 
 #define DEBUG 1
-
-#define HW_TIMER_PERIOD 100 /* 100ms */
+#define VEHICLE_TRACE 0 /* print the raw Q16.16 state of VehicleTask */
 
 /* Button Patterns */
 #define GAS_PEDAL_FLAG      0x08
 #define BRAKE_PEDAL_FLAG    0x04
 #define CRUISE_CONTROL_FLAG 0x02
+#define REPORT_FLAG         0x01 // dump the timing statistics
 
 /* Switch Patterns */
 #define TOP_GEAR_FLAG       0x00000002 // SW1
@@ -67,6 +89,11 @@
 #define LED_RED_16 0x00010000
 #define LED_RED_17 0x00020000
 
+#define LED_POSITION_MASK (LED_RED_17 | LED_RED_16 | LED_RED_15 | \
+                           LED_RED_14 | LED_RED_13 | LED_RED_12)
+#define LED_LOAD_MASK     (LED_RED_9 | LED_RED_8 | LED_RED_7 | \
+                           LED_RED_6 | LED_RED_5 | LED_RED_4)
+
 #define LED_GREEN_0 0x0001 // Cruise Control activated
 #define LED_GREEN_2 0x0002 // Cruise Control Button
 #define LED_GREEN_4 0x0010 // Brake Pedal
@@ -74,86 +101,55 @@
 
 /*
  * Definition of Tasks
+ *
+ * The periodic task set (periods, priorities, stacks and execution
+ * budgets) is described in cruise_tasks.h.
  */
 
-#define TASK_STACKSIZE 2048
-
-OS_STK StartTask_Stack[TASK_STACKSIZE]; 
-OS_STK ControlTask_Stack[TASK_STACKSIZE]; 
-OS_STK VehicleTask_Stack[TASK_STACKSIZE];
-OS_STK ButtonIO_Stack[TASK_STACKSIZE];
-OS_STK SwitchIO_Stack[TASK_STACKSIZE];
-OS_STK Watchdog_Stack[TASK_STACKSIZE];
-OS_STK Overload_Stack[TASK_STACKSIZE];
-OS_STK ExtraLoad_Stack[TASK_STACKSIZE];
-
-// Task Priorities
-
-#define STARTTASK_PRIO     5
-#define VEHICLETASK_PRIO  10
-#define CONTROLTASK_PRIO  12
-#define BUTTONIO_PRIO      7
-#define SWITCHIO_PRIO      8
-#define WATCHDOG_PRIO      1
-#define OVERLOAD_PRIO      3
-#define EXTRALOAD_PRIO     2
-
-// Task Periods
-#define CONTROL_PERIOD  300
-#define VEHICLE_PERIOD  300
-#define BUTTONS_PERIOD  300
-#define SWITCHES_PERIOD 300
-#define WATCHDOG_PERIOD 300
-#define OVERLOAD_PERIOD 300
-#define EXTRALOAD_PERIOD 300
+OS_STK StartTask_Stack[STACK_CANARY_WORDS + STACK_START]; // canary below (stacks.h)
+
+// Reporting period of the release overhead (ms)
+#define RELEASE_REPORT_PERIOD 5000
+
+// Overload detection: minimum CPU headroom in tenths of a percent
+#define MONITOR_HEADROOM_MIN 100
+
+// Load shedding (see shed.h): the headroom is averaged over the longest
+// period, and a job counts as at risk with less than SHED_MARGIN ms of
+// its period left before it started
+#define SHED_WINDOWS (VEHICLE_PERIOD / MONITOR_PERIOD)
+#define SHED_MARGIN  (3 * MONITOR_PERIOD / 2)
 
 /*
  * Definition of Kernel Objects 
  */
 
+// Message queues
+OS_EVENT *Buttons_Queue;
+void *Buttons_QueueStorage[BUTTON_EVENTS];
+
 // Mailboxes
-OS_EVENT *Mbox_Throttle;
-OS_EVENT *Mbox_Velocity;
-OS_EVENT *Mbox_Brake;
 OS_EVENT *Mbox_Engine;
 
-// Semaphores
-OS_EVENT *Vehicle_Semaphore;
-OS_EVENT *Control_Semaphore;
-OS_EVENT *Buttons_Semaphore;
-OS_EVENT *Switches_Semaphore;
-OS_EVENT *Watchdog_Semaphore;
-OS_EVENT *Overload_Semaphore;
-OS_EVENT *OKSignal_Semaphore;
-OS_EVENT *ExtraLoad_Semaphore;
-
-// SW-Timer
-OS_TMR *Vehicle_Timer;
-OS_TMR *Control_Timer;
-OS_TMR *Buttons_Timer;
-OS_TMR *Switches_Timer;
-OS_TMR *Watchdog_Timer;
-OS_TMR *Overload_Timer;
-OS_TMR *ExtraLoad_Timer;
+// Event flags: the vehicle mode (MODE_* bits of vehicle_mode.h)
+OS_FLAG_GRP *Mode_Flags;
 
 /*
  * Types
  */
 enum active {on = 2, off = 1};
-enum active cruise_control = off; 
-enum active gas_pedal = off;
-enum active brake_pedal = off;
-enum active top_gear = off;
-enum active engine = off;
 
 
 /*
  * Global variables
  */
-int delay; // Delay of HW-timer 
-INT16U led_green = 0; // Green LEDs
-INT32U led_red = 0;   // Red LEDs
 int desired_utilization = 0; // desired utilization of extra load
+int headroom_threshold = MONITOR_HEADROOM_MIN; // overload below this headroom (0.1 %)
+int overloaded = 0; // set by the monitor while headroom is below the threshold
+shed_t shed; // load shedding state, Monitor only
+volatile int shed_level = SHED_NONE; // current level of 'shed'
+volatile int report_requested = 0; // LogTask prints the timing statistics
+volatile INT8U mode = 0; // vehicle mode, written by mode_update() only
 
 
 /*
@@ -164,260 +160,165 @@ int buttons_pressed(void)
   return ~IORD_ALTERA_AVALON_PIO_DATA(D2_PIO_KEYS4_BASE);    
 }
 
+/* every change of the switches goes into the input trace (input_trace.h) */
 int switches_pressed(void)
 {
-  return IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_TOGGLES18_BASE);    
+#if INPUT_REPLAY
+  return input_trace_switches(input_replay_switches());
+#else
+  return input_trace_switches(IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_TOGGLES18_BASE));
+#endif
 }
 
 /*
- * ISR for HW Timer
+ * Applies 'event' to the vehicle mode (see vehicle_mode_rules.h) and
+ * returns the new mode. The changed bits are published through
+ * Mode_Flags and on the mode LEDs. The scheduler is locked so that the
+ * two writers (ButtonIO and SwitchIO) cannot interleave, and readers
+ * never see the flags half updated.
  */
-alt_u32 alarm_handler(void* context)
+INT8U mode_update(int event)
 {
-  OSTmrSignal(); /* Signals a 'tick' to the SW timers */
-
-  return delay;
+  vehicle_state_t vehicle;
+  INT8U old, new, err;
+
+  blackboard_read(&vehicle);
+  OSSchedLock();
+  old = mode;
+  new = mode_next(old, event, mode_cond(VEHICLE_INT(vehicle.velocity)));
+  if (new != old) {
+    mode = new;
+    if (old & ~new)
+      OSFlagPost(Mode_Flags, old & ~new, OS_FLAG_CLR, &err);
+    if (new & ~old)
+      OSFlagPost(Mode_Flags, new & ~old, OS_FLAG_SET, &err);
+  }
+  OSSchedUnlock();
+
+  if (new != old) {
+    display_set(DISPLAY_LED_GREEN, LED_GREEN_2 | LED_GREEN_4 | LED_GREEN_6,
+                (new & MODE_CRUISE ? LED_GREEN_2 : 0) |
+                (new & MODE_BRAKE ? LED_GREEN_4 : 0) |
+                (new & MODE_GAS ? LED_GREEN_6 : 0));
+    display_set(DISPLAY_LED_RED, LED_RED_0 | LED_RED_1,
+                (new & MODE_ENGINE ? LED_RED_0 : 0) |
+                (new & MODE_TOP_GEAR ? LED_RED_1 : 0));
+    LOG(LOG_MODE_CHANGE, event, old, new, 0);
+  }
+  return new;
 }
 
-static int b2sLUT[] = {0x40, //0
-  0x79, //1
-  0x24, //2
-  0x30, //3
-  0x19, //4
-  0x12, //5
-  0x02, //6
-  0x78, //7
-  0x00, //8
-  0x18, //9
-  0x3F, //-
-};
-
 /*
- * convert int to seven segment display format
+ * output current velocity on the seven segement display (HEX3..HEX0),
+ * the shadow register is only written when the digits change
  */
-int int2seven(int inval){
-  return b2sLUT[inval];
-}
+void show_velocity_on_sevenseg(INT16S velocity){
+  static INT32U shown = 0xffffffff;
+  INT32U out = sevenseg_word(velocity);
 
-/*
- * output current velocity on the seven segement display
- */
-void show_velocity_on_sevenseg(INT8S velocity){
-  int tmp = velocity;
-  int out;
-  INT8U out_high = 0;
-  INT8U out_low = 0;
-  INT8U out_sign = 0;
-
-  if(velocity < 0){
-    out_sign = int2seven(10);
-    tmp *= -1;
-  }else{
-    out_sign = int2seven(0);
+  if (out != shown) {
+    display_write(DISPLAY_HEX_LOW, out);
+    shown = out;
   }
-
-  out_high = int2seven(tmp / 10);
-  out_low = int2seven(tmp - (tmp/10) * 10);
-
-  out = int2seven(0) << 21 |
-    out_sign << 14 |
-    out_high << 7  |
-    out_low;
-  IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_LOW28_BASE,out);
 }
 
 /*
- * shows the target velocity on the seven segment display (HEX5, HEX4)
+ * shows the target velocity on the seven segment display (HEX7..HEX4)
  * when the cruise control is activated (0 otherwise)
  */
-void show_target_velocity(INT8U target_vel)
+void show_target_velocity(INT16S target_vel)
 { 
-  //printf("target vel in here: %d \n", target_vel);
-  int tmp = target_vel;
-  int out;
-  INT8U out_high = 0;
-  INT8U out_low = 0;
-
-  out_high = int2seven(tmp / 10);
-  out_low = int2seven(tmp - (tmp/10) * 10);
-
-  out = out_high << 7 | out_low;
-  if (cruise_control == on) {
-    IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_HIGH28_BASE, out);
-  } else { // show velocity of zero if cruise control is off
-    out = int2seven(0) << 7 | int2seven(0);
-    IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_HIGH28_BASE, out);
+  static INT32U shown = 0xffffffff;
+  INT32U out = sevenseg_word((mode & MODE_CRUISE) ? target_vel : 0);
+
+  if (out != shown) {
+    display_write(DISPLAY_HEX_HIGH, out);
+    shown = out;
   }
 }
 
 /*
- * indicates the position of the vehicle on the track with the four leftmost red LEDs
- * LEDR17: [0m, 400m)
- * LEDR16: [400m, 800m)
- * LEDR15: [800m, 1200m)
- * LEDR14: [1200m, 1600m)
- * LEDR13: [1600m, 2000m)
- * LEDR12: [2000m, 2400m]
+ * indicates the position of the vehicle on the track with the red LED
+ * of its track segment (see track.c)
  */
 void show_position(INT16U position)
 {
-    led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-    if (0 <= position && position < 400) {
-        INT32U led_mask = led_red | LED_RED_17;  // turn on LEDR17
-        led_mask = led_mask & ~LED_RED_16;       // turn off LEDR16
-        led_mask = led_mask & ~LED_RED_15;       // turn off LEDR15
-        led_mask = led_mask & ~LED_RED_14;       // turn off LEDR14
-        led_mask = led_mask & ~LED_RED_13;       // turn off LEDR13
-        led_mask = led_mask & ~LED_RED_12;       // turn off LEDR12
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_mask);
-    } else if (position < 800) {
-        INT32U led_mask = led_red & ~LED_RED_17; // turn off LEDR17
-        led_mask = led_mask | LED_RED_16;        // turn on LEDR16
-        led_mask = led_mask & ~LED_RED_15;       // turn off LEDR15
-        led_mask = led_mask & ~LED_RED_14;       // turn off LEDR14
-        led_mask = led_mask & ~LED_RED_13;       // turn off LEDR13
-        led_mask = led_mask & ~LED_RED_12;       // turn off LEDR12
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_mask);
-    } else if (position < 1200) {
-        INT32U led_mask = led_red & ~LED_RED_17; // turn off LEDR17
-        led_mask = led_mask & ~LED_RED_16;       // turn off LEDR16
-        led_mask = led_mask |  LED_RED_15;       // turn on LEDR15
-        led_mask = led_mask & ~LED_RED_14;       // turn off LEDR14
-        led_mask = led_mask & ~LED_RED_13;       // turn off LEDR13
-        led_mask = led_mask & ~LED_RED_12;       // turn off LEDR12
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_mask);
-    } else if (position < 1600) {
-        INT32U led_mask = led_red & ~LED_RED_17; // turn off LEDR17
-        led_mask = led_mask & ~LED_RED_16;       // turn off LEDR16
-        led_mask = led_mask & ~LED_RED_15;       // turn off LEDR15
-        led_mask = led_mask | LED_RED_14;        // turn on LEDR14
-        led_mask = led_mask & ~LED_RED_13;       // turn off LEDR13
-        led_mask = led_mask & ~LED_RED_12;       // turn off LEDR12
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_mask);
-    } else if (position < 2000) {
-        INT32U led_mask = led_red & ~LED_RED_17; // turn off LEDR17
-        led_mask = led_mask & ~LED_RED_16;       // turn off LEDR16
-        led_mask = led_mask & ~LED_RED_15;       // turn off LEDR15
-        led_mask = led_mask & ~LED_RED_14;       // turn off LEDR14
-        led_mask = led_mask | LED_RED_13;        // turn on LEDR13
-        led_mask = led_mask & ~LED_RED_12;       // turn off LEDR12
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_mask);
-    } else if (position <= 2400) {
-        INT32U led_mask = led_red & ~LED_RED_17; // turn off LEDR17
-        led_mask = led_mask & ~LED_RED_16;       // turn off LEDR16
-        led_mask = led_mask & ~LED_RED_15;       // turn off LEDR15
-        led_mask = led_mask & ~LED_RED_14;       // turn off LEDR14
-        led_mask = led_mask & ~LED_RED_13;       // turn off LEDR13
-        led_mask = led_mask | LED_RED_12;        // turn on LEDR12
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_mask);
-    } else {
-        INT32U led_mask = led_red & ~LED_RED_17; // turn off LEDR17
-        led_mask = led_mask & ~LED_RED_16;       // turn off LEDR16
-        led_mask = led_mask & ~LED_RED_15;       // turn off LEDR15
-        led_mask = led_mask & ~LED_RED_14;       // turn off LEDR14
-        led_mask = led_mask & ~LED_RED_13;       // turn off LEDR13
-        led_mask = led_mask & ~LED_RED_12;       // turn off LEDR12
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_mask);
-    }
+  PROF_BEGIN(PROF_POSITION);
+  display_set(DISPLAY_LED_RED, LED_POSITION_MASK, track_led_mask(position));
+  PROF_END(PROF_POSITION);
 }
 
 /*
  * The task 'VehicleTask' is the model of the vehicle being simulated. It updates variables like
  * acceleration and velocity based on the input given to the model.
  * 
- * The car model is equivalent to moving mass with linear resistances acting upon it.
- * Therefore, if left one, it will stably stop as the velocity converges to zero on a flat surface.
- * You can prove that easily via basic LTI systems methods.
+ * The physics are integrated in Q16.16 fixed point by vehicle_step() (see vehicle_model.c).
+ * With VEHICLE_TRACE set, the inputs and the resulting state of every step are printed
+ * in hex so that the trajectory can be checked against the host reference model.
  */
 void VehicleTask(void* pdata)
 { 
-  INT8U err;  
-
-  // constants that should not be modified
-  const unsigned int wind_factor = 1;
-  const unsigned int brake_factor = 4;
-  const unsigned int gravity_factor = 2;
   // variables relevant to the model and its simulation on top of the RTOS
   
-  void* msg;
-  INT8U* throttle; 
-  INT16S acceleration;  
-  INT16U position = 0; 
-  INT16S velocity = 0; 
+  msg_t* msg;
+  act_cmd_t cmd;
+  INT8U throttle = 0; 
+  vehicle_t vehicle;
+  vehicle_state_t state;
   enum active brake_pedal_local = off;
   enum active engine_local = off;
 
+  vehicle_init(&vehicle, VEHICLE_PERIOD);
+
   printf("Vehicle task created!\n");
 
   while(1)
   {
-    err = OSMboxPost(Mbox_Velocity, (void *) &velocity);
-    
-    //OSTimeDlyHMSM(0,0,0,VEHICLE_PERIOD); 
-    OSSemPend(Vehicle_Semaphore, 0, &err);
+    wait_for_release(pdata);
+    PROF_BEGIN(PROF_VEHICLE);
 
-    /* Non-blocking read of mailbox: 
-       - message in mailbox: update throttle
-       - no message:         use old throttle
+    /* Non-blocking read of the actuator commands:
+       - new throttle command: update throttle, else keep the old one
+       - brake commands: applied in the order they were issued
        */
-    msg = OSMboxPend(Mbox_Throttle, 1, &err); 
-    if (err == OS_NO_ERR) 
-      throttle = (INT8U*) msg;
-    /* Same for the brake signal that bypass the control law */
-    msg = OSMboxPend(Mbox_Brake, 1, &err); 
-    if (err == OS_NO_ERR) {
-      brake_pedal_local = (enum active) msg;
-    }
+    if (act_read(ACT_THROTTLE, &cmd))
+      throttle = (INT8U) cmd.value;
+    while (act_read(ACT_BRAKE, &cmd))
+      brake_pedal_local = (enum active) cmd.value;
     /* Same for the engine signal that bypass the control law */
-    msg = OSMboxPend(Mbox_Engine, 1, &err);
-    if (err == OS_NO_ERR) {
-      engine_local = (enum active) msg;
+    msg = msg_accept(Mbox_Engine);
+    if (msg) {
+      engine_local = (enum active) msg->value;
+      msg_free(msg);
     }
 
     // vehichle cannot effort more than 80 units of throttle
-    if (*throttle > 80) *throttle = 80;
-
-    // brakes + wind
-    if (brake_pedal == off)
-    {
-      // wind resistance
-      acceleration = - wind_factor*velocity;
-      // actuate with engines
-      if (engine == on){
-        acceleration += (*throttle);
-        //printf("engine on");
-      }
-      //printf("Engine (2=on, 1=off): %d\n", engine);
-
-      // gravity effects
-      if (400 <= position && position < 800)
-        acceleration -= gravity_factor; // traveling uphill
-      else if (800 <= position && position < 1200)
-        acceleration -= 2*gravity_factor; // traveling steep uphill
-      else if (1600 <= position && position < 2000)
-        acceleration += 2*gravity_factor; //traveling downhill
-      else if (2000 <= position)
-        acceleration += gravity_factor; // traveling steep downhill
-    }
-    // if the engine and the brakes are activated at the same time,
-    // we assume that the brake dynamics dominates, so both cases fall
-    // here.
-    else 
-      acceleration = - brake_factor*velocity;
-
-    printf("Position: %d m\n", position);
-    printf("Velocity: %d m/s\n", velocity);
-    printf("Accell: %d m/s2\n", acceleration);
-    printf("Throttle: %d V\n", *throttle);
-
-    position = position + velocity * VEHICLE_PERIOD / 1000;
-    velocity = velocity  + acceleration * VEHICLE_PERIOD / 1000.0;
-    // reset the position to the beginning of the track
-    if(position > 2400)
-      position = 0;
-
-    show_velocity_on_sevenseg((INT8S) velocity);
-    show_position(position); // new
+    if (throttle > 80) throttle = 80;
+
+    vehicle_step(&vehicle, throttle, brake_pedal_local == on, engine_local == on);
+
+#if VEHICLE_TRACE
+    printf("V %d %d %d %08lx %08lx %08lx\n", throttle, brake_pedal_local == on, engine_local == on,
+           (unsigned long) vehicle.position, (unsigned long) vehicle.velocity,
+           (unsigned long) vehicle.acceleration);
+#elif !TELEMETRY
+    LOG(LOG_VEHICLE_STATE, VEHICLE_INT(vehicle.position), VEHICLE_INT(vehicle.velocity),
+        VEHICLE_INT(vehicle.acceleration), throttle);
+#endif
+
+    /* Publish the new state for the other tasks (never blocks) */
+    state.position = vehicle.position;
+    state.velocity = vehicle.velocity;
+    state.acceleration = vehicle.acceleration;
+    state.time = OSTimeGet();
+    blackboard_publish(&state);
+#if TELEMETRY
+    telem_sample(state.time, vehicle.position, vehicle.velocity, throttle, mode);
+#endif
+
+    show_velocity_on_sevenseg((INT16S) VEHICLE_INT(vehicle.velocity));
+    show_position((INT16U) VEHICLE_INT(vehicle.position)); // new
+    PROF_END(PROF_VEHICLE);
   }
 } 
 
@@ -427,354 +328,368 @@ void VehicleTask(void* pdata)
  */
 void ControlTask(void* pdata)
 {
-  INT8U err;
   INT8U throttle = 0; /* Value between 0 and 80, which is interpreted as between 0.0V and 8.0V */
-  void* msg;
-  INT16S* current_velocity = 0;
-  INT16S* target_velocity = 0;
+  INT8U posted_throttle = 0xff; /* last value sent to the vehicle */
+  vehicle_state_t vehicle;
+  INT16S current_velocity;
+  INT16S target_velocity = 0;
+  enum active cruise_active = off; /* cruise state seen in the previous period */
+  INT8U m;
+  pi_ctrl_t pi;
 
-  //enum active gas_pedal = off;
-  //enum active top_gear = off;
+  pi_init(&pi, CONTROL_KP, CONTROL_KI);
 
   printf("Control Task created\n");
 
   while(1)
   {
-    void* msg = OSMboxPend(Mbox_Velocity, 1, &err); 
-    if (err == OS_NO_ERR) {
-      current_velocity = (INT16S*) msg;
-    }
-
-// Here you can use whatever technique or algorithm that you prefer to control
-    // the velocity via the throttle. There are no right and wrong answer to this controller, so
-    // be free to use anything that is able to maintain the cruise working properly. You are also
-    // allowed to store more than one sample of the velocity. For instance, you could define
-    //
-    // INT16S previous_vel;
-    // INT16S pre_previous_vel;
-    // ...
-    //
-    // If your control algorithm/technique needs them in order to function. 
-    
-    // switch off LEDG0 when cruise control is inactive
+    PROF_BEGIN(PROF_CONTROL);
+    m = mode;
+    blackboard_read(&vehicle);
+    current_velocity = (INT16S) VEHICLE_INT(vehicle.velocity);
+
+#if TELEMETRY
+    telem_target(target_velocity);
+#else
+    LOG(LOG_TARGET_VEL, target_velocity, 0, 0, 0);
+#endif
+    show_target_velocity(target_velocity);
+
+    if (!(m & MODE_CRUISE)){
+        // switch off LEDG0 when cruise control is inactive
+        display_off(DISPLAY_LED_GREEN, LED_GREEN_0);
 
-    printf("Target velocity: %d \n", *target_velocity);
-    show_target_velocity(*target_velocity);
+        if (m & MODE_GAS){
+          target_velocity = current_velocity;
+        }
+        cruise_active = off;
 
-    if (cruise_control == off){
-        led_green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, led_green & ~LED_GREEN_0);
+    } else if (target_velocity >= MODE_CRUISE_MIN_VELOCITY){
+        // switch on LEDG0 when cruise control is active
+        display_on(DISPLAY_LED_GREEN, LED_GREEN_0);
 
-        void* msg = OSMboxPend(Mbox_Velocity, 1, &err); 
-        if (err == OS_NO_ERR) {
-          current_velocity = (INT16S*) msg;
-        }
-        if (gas_pedal == on){
-          *target_velocity = *current_velocity;
+        // bumpless engagement: start from the throttle currently applied
+        if (cruise_active == off) {
+          pi_reset(&pi, throttle);
+          cruise_active = on;
         }
 
-    } else if (cruise_control == on && *target_velocity >= 20){
-        // switch off LEDG0 when cruise control is inactive
-        led_green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, led_green | LED_GREEN_0);
-
-        // controller for cruise control
-        if ((*current_velocity - *target_velocity) < 0) {
-            brake_pedal = off;
-            throttle = 40;
-            err = OSMboxPost(Mbox_Throttle, (void*) &throttle);
-        } else if ((*current_velocity - *target_velocity) > 0){
-            brake_pedal = on;
-            err = OSMboxPost(Mbox_Brake, (void*) &brake_pedal);
-        }
+        // PI controller for cruise control
+        PROF_BEGIN(PROF_PI_STEP);
+        throttle = pi_step(&pi, VEHICLE_TO_Q16(target_velocity), vehicle.velocity);
+        PROF_END(PROF_PI_STEP);
     }
 
-    if(gas_pedal == on) {
+    if(m & MODE_GAS) {
       throttle = 40;
-      err = OSMboxPost(Mbox_Throttle, (void*) &throttle);
-    } else {
-      throttle = throttle/1.0001; // slowly decrease throttle so that vehicle does not stop immediately
-      err = OSMboxPost(Mbox_Throttle, (void*) &throttle);
+    } else if (cruise_active == off && throttle > 0) {
+      throttle--; // slowly decrease throttle so that vehicle does not stop immediately
+    }
+
+    // the vehicle keeps the last throttle, so only post when it changes
+    if (throttle != posted_throttle) {
+      act_post(ACT_THROTTLE, throttle);
+      posted_throttle = throttle;
     }
 
-    // //OSTimeDlyHMSM(0,0,0, CONTROL_PERIOD);
-    OSSemPend(Control_Semaphore, 0, &err);
+    PROF_END(PROF_CONTROL);
+
+    // nothing to control until the engine runs: pend on the mode instead
+    if (!(m & MODE_ENGINE) && throttle == 0)
+      wait_for_flags(pdata, Mode_Flags, MODE_ENGINE);
+    else
+      wait_for_release(pdata);
   }
 }
 
+/* ButtonIO posts at most one brake command per queued key event, so the
+ * brake ring can take a full button queue between two VehicleTask jobs */
+CRUISE_STATIC_ASSERT(brake_ring_size, ACT_FIFO_SIZE >= BUTTON_EVENTS);
+
+/* the period of ButtonIO is the minimum inter-arrival of host/rta */
+CRUISE_STATIC_ASSERT(buttons_period, BUTTONS_PERIOD == BUTTON_DEBOUNCE_MS);
+
+/*
+ * The task 'ButtonIO' handles the key presses posted by the KEY PIO
+ * interrupt (see buttons.c) as soon as they happen.
+ */
 void ButtonIO(void* pdata){
   INT8U err;
   int buttons;
-  
-  INT16S* current_velocity = 0;
+  button_event_t* event;
+  INT8U old, new;
 
   while(1){
-    OSSemPend(Buttons_Semaphore, 0, &err);
-    buttons = buttons_pressed();
-    led_green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
-
-    void* msg = OSMboxPend(Mbox_Velocity, 1, &err); 
-      if (err == OS_NO_ERR) {
-        current_velocity = (INT16S*) msg;
-      }
-
-    if (buttons & CRUISE_CONTROL_FLAG ) {  /* push button1 */
-        if(cruise_control == on) {
-
-          IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, led_green & ~LED_GREEN_2);
-          cruise_control = off;
-          //target_velocity = 0;
-          
-        } else if(top_gear == on) {
-
-            void* msg = OSMboxPend(Mbox_Velocity, 1, &err); 
-            if (err == OS_NO_ERR) {
-              current_velocity = (INT16S*) msg;
-            }
-            led_green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
-            if (*current_velocity >= 20 && brake_pedal == off && gas_pedal == off) {
-                //target = *current_velocity;
-                //show_target_velocity((INT8U) (target / 10));
-                
-                IOWR_ALTERA_AVALON_PIO_DATA (DE2_PIO_GREENLED9_BASE, led_green | LED_GREEN_2); // LEDG2 on
-                //target_velocity = current_velocity;
-                cruise_control = on;
-            }
-        }
-    }
-
-    led_green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
-    if (buttons & GAS_PEDAL_FLAG) {
-      if (gas_pedal == on){
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, led_green & ~LED_GREEN_6);
-        gas_pedal = off;
-        void* msg = OSMboxPend(Mbox_Velocity, 1, &err); 
-        if (err == OS_NO_ERR) {
-          current_velocity = (INT16S*) msg;
-        }
-        //err = OSMboxPost(Mbox_Brake, (void *) &brake_pedal);
-      } else {
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, led_green | LED_GREEN_6);
-        gas_pedal = on;
-        
-        led_green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
-
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, led_green & ~LED_GREEN_2);
-        cruise_control = off;
-        //target_velocity = 0;
-        
-        //err = OSMboxPost(Mbox_Brake, (void *) &brake_pedal);
-      }
-    }
-
-    led_green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
-    if (buttons & BRAKE_PEDAL_FLAG) {
-      if (brake_pedal == on){
-
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, led_green & ~LED_GREEN_4);
-        brake_pedal = off;
-        void* msg = OSMboxPend(Mbox_Velocity, 1, &err); 
-        if (err == OS_NO_ERR) {
-          current_velocity = (INT16S*) msg;
-        }
-        //err = OSMboxPost(Mbox_Brake, (void *) &brake_pedal);
-      } else {
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, led_green | LED_GREEN_4);
-        brake_pedal = on;
-
-        led_green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
-
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, led_green & ~LED_GREEN_2);
-        cruise_control = off;
-        //target_velocity = 0;
-        //err = OSMboxPost(Mbox_Brake, (void *) &brake_pedal);
-      }
+    task_job_complete(pdata);
+    event = (button_event_t*) OSQPend(Buttons_Queue, 0, &err);
+    if (err != OS_NO_ERR)
+      continue;
+    task_job_start(pdata, event->stamp);
+    PROF_BEGIN(PROF_BUTTONS);
+    buttons = event->keys;
+    LOG(LOG_BUTTON_EVENT, buttons, (INT32S) (timestamp_now() - event->stamp), 0, 0);
+
+    if (buttons & REPORT_FLAG)
+      report_requested = 1;
+
+    old = mode;
+    if (buttons & CRUISE_CONTROL_FLAG)  /* push button1 */
+      mode_update(MODE_EV_CRUISE);
+    if (buttons & GAS_PEDAL_FLAG)
+      mode_update(MODE_EV_GAS);
+    if (buttons & BRAKE_PEDAL_FLAG)
+      mode_update(MODE_EV_BRAKE);
+    new = mode;
+
+    if ((old ^ new) & MODE_BRAKE) {
+      if (act_post(ACT_BRAKE, new & MODE_BRAKE ? on : off) < 0)
+        LOG(LOG_ACT_LOST, ACT_BRAKE, new & MODE_BRAKE ? on : off, 0, 0);
     }
+    PROF_END(PROF_BUTTONS);
   }
 }
 
 // new task
 void SwitchIO(void* pdata)
 {
-    INT8U err;
-    int is_SW0_active;
-    int is_SW1_active;
-    INT16S* current_velocity = NULL;
+    int switches;
+    INT8U m;
+    enum active engine, engine_sent = off;
 
     while(1) {
-        OSSemPend(Switches_Semaphore, 0, &err);
+        wait_for_release(pdata);
+        PROF_BEGIN(PROF_SWITCHES);
 
         desired_utilization = get_desired_utilization_from_switches(); // set global variable
 
-        is_SW0_active = switches_pressed() & ENGINE_FLAG;
-        is_SW1_active = switches_pressed() & TOP_GEAR_FLAG;
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        led_green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
-
-        // 1 - ENGINE
-        if(is_SW0_active) {
-            if(engine == off) {
-                engine = on;
-                IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red | LED_RED_0); // turn LED on
-                err = OSMboxPost(Mbox_Engine, (void*) &engine);
-            }
-        } else { // SW0 is not active
-            if(engine == on) {
-                // read out current velocity
-                /* Non-blocking read of mailbox: 
-                - message in mailbox: update velocity
-                - no message:         use old velocity
-                */
-                void* msg = OSMboxPend(Mbox_Velocity, 1, &err);
-                if (err == OS_NO_ERR) {
-                    current_velocity = (INT16S*) msg;
-                }
-
-                // Only turn off motor if the speed of the car is 0
-                if(*current_velocity == 0) { 
-                    engine = off;
-                    IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red & ~LED_RED_0); // turn LED off
-                }
-            }
-        }
-
-        // 2 - TOP GEAR
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        if(is_SW1_active) {
-            if(top_gear == off) {
-                top_gear = on;
-                IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red | LED_RED_1); // turn LED on
-            }
-        } else { // SW1 is not active
-            if(top_gear == on) {
-                top_gear = off;
-                IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red & ~LED_RED_1); // turn LED off
-
-                // cruise control is only active in top gear
-                cruise_control = off;
-                IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_green & ~LED_GREEN_2);
-            }
-        }
+        switches = switches_pressed();
+
+        // 1 - ENGINE (it only stops once the vehicle stands still)
+        m = mode;
+        if ((switches & ENGINE_FLAG) && !(m & MODE_ENGINE))
+            m = mode_update(MODE_EV_ENGINE_ON);
+        else if (!(switches & ENGINE_FLAG) && (m & MODE_ENGINE))
+            m = mode_update(MODE_EV_ENGINE_OFF);
+
+        // the engine state is sent again every poll until VehicleTask has it
+        engine = m & MODE_ENGINE ? on : off;
+        if (engine != engine_sent && msg_send(Mbox_Engine, engine) == OS_NO_ERR)
+            engine_sent = engine;
+
+        // 2 - TOP GEAR (cruise control is only active in top gear)
+        m = mode;
+        if ((switches & TOP_GEAR_FLAG) && !(m & MODE_TOP_GEAR))
+            mode_update(MODE_EV_TOP_GEAR_ON);
+        else if (!(switches & TOP_GEAR_FLAG) && (m & MODE_TOP_GEAR))
+            mode_update(MODE_EV_TOP_GEAR_OFF);
+        PROF_END(PROF_SWITCHES);
     }
 }
 
-void Watchdog(void* pdata){
-  INT8U err;
-  while(1){
-    OSSemPend(Watchdog_Semaphore, 0, &err);
+/*
+ * The task 'Monitor' measures the CPU utilisation of every MONITOR_PERIOD
+ * window from the idle task counter. It raises an overload as soon as
+ * the remaining headroom drops below 'headroom_threshold' and prints the
+ * recent utilisation history when it does. It also checks the stack
+ * canaries of all tasks.
+ *
+ * A single window over the threshold is not acted upon: a load that
+ * fits the longest period may still fill a window. Load is shed (see
+ * shed.h) when the headroom averaged over SHED_WINDOWS is below the
+ * threshold, or when a control path job is at risk of missing its
+ * deadline.
+ */
+void Monitor(void* pdata){
+  INT16U util;
+  INT16U history[MONITOR_HISTORY];
+  INT32U sum;
+  int i, n, headroom, risk, level;
 
-    OSSemPend(OKSignal_Semaphore, 299, &err);
+  while(1){
+    wait_for_release(pdata);
+    PROF_BEGIN(PROF_MONITOR);
+
+    util = monitor_sample();
+    stacks_check();
+
+    n = monitor_history(history, SHED_WINDOWS);
+    for (i = 0, sum = 0; i < n; ++i)
+      sum += history[i];
+    headroom = n ? 1000 - (int) (sum / n) : 1000;
+    risk = tasks_at_risk(SHED_MARGIN);
+    level = shed_update(&shed, risk || headroom < headroom_threshold,
+                        !risk && headroom >= headroom_threshold + SHED_HYSTERESIS);
+    if (level != shed_level) {
+      LOG(LOG_SHED, shed_level, level, headroom / 10, risk);
+      shed_level = level;
+      tasks_shed(level);
+    }
 
-    if (err != OS_NO_ERR){
-      printf("OVERLOADED!");
+    if (1000 - util < headroom_threshold) {
+      if (!overloaded) {
+        overloaded = 1;
+        LOG(LOG_OVERLOAD, util / 10, util % 10, 0, 0);
+        n = monitor_history(history, MONITOR_HISTORY);
+        for (i = 0; i + 4 <= n; i += 4)
+          LOG(LOG_UTIL_HISTORY, history[i] / 10, history[i+1] / 10,
+              history[i+2] / 10, history[i+3] / 10);
+      }
+    } else if (overloaded) {
+      overloaded = 0;
+      LOG(LOG_OVERLOAD_CLEAR, util / 10, util % 10, 0, 0);
     }
+    PROF_END(PROF_MONITOR);
   }
 }
 
-void Overload(void* pdata){
-  INT8U err;
-  while(1){
-    OSSemPend(Overload_Semaphore, 0, &err);
-    OSSemPost(OKSignal_Semaphore);
-  }
+/*
+ * Share of its period that ExtraLoad may take at the current load
+ * shedding level, asked by load_run_limited() every LOAD_CHUNK_MS: its
+ * wcet budget of cruise_tasks.h, which host/rta assumes, half of it
+ * while it is throttled and none while it is suspended. A job therefore
+ * gives the CPU back within a chunk after Monitor raises the level. The
+ * critical section is also a preemption point of the busy loop on the
+ * host port.
+ */
+static INT32U extraload_limit(void)
+{
+  int level;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  OS_ENTER_CRITICAL();
+  level = shed_level;
+  OS_EXIT_CRITICAL();
+  return shed_budget(level, CRIT_BEST_EFFORT, EXTRALOAD_WCET) / (EXTRALOAD_PERIOD * 10);
+}
 
+/* Time stamp ticks the running task has spent switched out (prof.c) */
+static uint32_t switched_out(void)
+{
+  return prof_switched_out[OSPrioCur];
 }
 
+/*
+ * The task 'ExtraLoad' occupies the CPU for desired_utilization % of
+ * every EXTRALOAD_PERIOD, using the busy loop calibrated in StartTask,
+ * but never for more than extraload_limit(). It logs the CPU
+ * time it actually burned, which falls short of the request when it is
+ * preempted for long.
+ */
 void ExtraLoad(void* pdata){
-    int i, x;
-    INT8U err;
+    INT32U achieved, percent;
     
     while(1)
     {
-        OSSemPend(ExtraLoad_Semaphore, 0, &err);
-        printf("Desired utilization %d \n", desired_utilization);
+        wait_for_release(pdata);
+        PROF_BEGIN(PROF_EXTRALOAD);
 
-        //PERF_START_MEASURING(PERFORMANCE_COUNTER_BASE);
-        for(i = 0; i <= desired_utilization*60; ++i) {
-            x = x + 1;
-        }
-        //PERF_STOP_MEASURING(PERFORMANCE_COUNTER_BASE);
-        //alt_u64 measured_time = perf_get_total_time(PERFORMANCE_COUNTER_BASE);
-        //PERF_RESET(PERFORMANCE_COUNTER_BASE);
-        //printf("(%d ticks)\n", measured_time);
+        percent = desired_utilization;
+        achieved = load_run_limited(percent, EXTRALOAD_PERIOD, extraload_limit);
+        LOG(LOG_EXTRA_LOAD, percent, achieved / 10, achieved % 10, 0);
+        PROF_END(PROF_EXTRALOAD);
     }
 }
 
-// Returns the desired utilization (in %) which is determined by the switch position
-int get_desired_utilization_from_switches() {
-    // Determine which switches are pressed
-    int is_SW4_active = switches_pressed() & SW4_FLAG;
-    int is_SW5_active = switches_pressed() & SW5_FLAG;
-    int is_SW6_active = switches_pressed() & SW6_FLAG;
-    int is_SW7_active = switches_pressed() & SW7_FLAG;
-    int is_SW8_active = switches_pressed() & SW8_FLAG;
-    int is_SW9_active = switches_pressed() & SW9_FLAG;
-
-// Turn on LEDs where the switch is active
-    if (is_SW4_active) {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red | LED_RED_4); 
-        is_SW4_active = 1;
-    } else {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red & ~LED_RED_4); 
-        is_SW4_active = 0;
-    }
-    if (is_SW5_active) {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red | LED_RED_5); 
-        is_SW5_active = 1;
-    } else {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red & ~LED_RED_5); 
-        is_SW5_active = 0;
-    }
-    if (is_SW6_active) {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red | LED_RED_6);
-        is_SW6_active = 1;
-    } else {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red & ~LED_RED_6); 
-        is_SW6_active = 0;
-    }
-    if (is_SW7_active) {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red | LED_RED_7); 
-        is_SW7_active = 1;
-    } else {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red & ~LED_RED_7); 
-        is_SW7_active = 0;
-    }
-    if (is_SW8_active) {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red | LED_RED_8); 
-        is_SW8_active = 1;
-    } else {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red & ~LED_RED_8); 
-        is_SW8_active = 0;
+/*
+ * The task 'DisplayTask' composes one output frame per DISPLAY_PERIOD:
+ * it writes the shadow LED and seven-segment registers that changed
+ * since the previous frame to their PIOs.
+ */
+void DisplayTask(void* pdata)
+{
+  while(1)
+  {
+    wait_for_release(pdata);
+    PROF_BEGIN(PROF_DISPLAY);
+    display_refresh();
+    PROF_END(PROF_DISPLAY);
+  }
+}
+
+#if TELEMETRY
+/*
+ * Writes the queued telemetry frames to the JTAG UART (see telemetry.h),
+ * called by LogTask so that frames never interleave with log text
+ */
+void telemetry_send(void)
+{
+  static uint8_t frame[TELEM_FRAME_SIZE];
+  int n = 0, size;
+
+  while ((size = telem_take(frame)) > 0) {
+    fwrite(frame, 1, size, stdout);
+    ++n;
+  }
+  if (n)
+    fflush(stdout);
+}
+#endif
+
+/*
+ * The task 'LogTask' runs at the lowest priority and emits the records
+ * that the other tasks pushed into the log ring. On request (KEY0) it
+ * also prints the jitter and response time statistics of all tasks, the
+ * table of profiling sections, the stack usage, the key presses lost to
+ * a full button queue, the PIO writes of the display, the log records
+ * dropped and the input trace.
+ */
+void LogTask(void* pdata)
+{
+  int n = 0;
+
+  while(1)
+  {
+    wait_for_release(pdata);
+    PROF_BEGIN(PROF_LOG);
+    if (++n == RELEASE_REPORT_PERIOD / LOG_PERIOD) {
+      release_report();
+      n = 0;
     }
-    if (is_SW9_active) {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red | LED_RED_9); 
-        is_SW9_active = 1;
-    } else {
-        led_red = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
-        IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, led_red & ~LED_RED_9); 
-        is_SW9_active = 0;
+    log_drain();
+#if TELEMETRY
+    telemetry_send();
+#endif
+    PROF_END(PROF_LOG);
+    if (report_requested) {
+      report_requested = 0;
+      tasks_report();
+      prof_report();
+      stacks_report();
+      msgpool_report();
+      act_report();
+      printf("buttons: %lu presses lost to a full queue\n", (unsigned long) buttons_lost());
+      printf("display: %lu PIO writes\n", (unsigned long) display_bus_writes());
+      printf("log: %lu records dropped\n", (unsigned long) log_dropped());
+      printf("load shedding: level %d, %lu switches, %u calm windows to step back\n",
+             shed_level, (unsigned long) shed.switches, (unsigned) shed.hold);
+      input_trace_dump();
+#if TELEMETRY
+      printf("telemetry: %lu frames dropped\n", (unsigned long) telem_dropped());
+#endif
     }
+  }
+}
 
-    // Calculate the binary number used for calculating the utilization
-    int binary_number = is_SW4_active + 2 * is_SW5_active + 4 * is_SW6_active +
-                        8 * is_SW7_active + 16 * is_SW8_active + 32 * is_SW9_active;
+// Returns the desired utilization (in %) which is determined by the switch position
+int get_desired_utilization_from_switches() {
+    PROF_BEGIN(PROF_UTIL_SW);
+    int switches = switches_pressed();
+
+    // Turn on LEDs where the switch is active (SW4-SW9 -> LEDR4-LEDR9)
+    display_set(DISPLAY_LED_RED, LED_LOAD_MASK, switches);
+
+    // SW4 is the least significant bit of the binary number
+    int binary_number = (switches & (SW4_FLAG | SW5_FLAG | SW6_FLAG |
+                                     SW7_FLAG | SW8_FLAG | SW9_FLAG)) >> 4;
 
     int desired_utilization_loc = 2 * binary_number;
     if (desired_utilization_loc > 100) {
         desired_utilization_loc = 100;
     }
 
+    PROF_END(PROF_UTIL_SW);
     return desired_utilization_loc;
 }
 
@@ -785,38 +700,49 @@ int get_desired_utilization_from_switches() {
 void StartTask(void* pdata)
 {
   INT8U err;
-  void* context;
 
-  static alt_alarm alarm;     /* Is needed for timer ISR function */
+  /* All LED and seven-segment output goes through the shadow registers */
+  display_init();
+  sevenseg_init();
 
-  /* Base resolution for SW timer : HW_TIMER_PERIOD ms */
-  delay = alt_ticks_per_second() * HW_TIMER_PERIOD / 1000; 
-  printf("delay in ticks %d\n", delay);
+  /* Measure the idle counts of one monitor window on an idle CPU */
+  monitor_init(MONITOR_PERIOD * OS_TICKS_PER_SEC / 1000);
 
-  /* 
-   * Create Hardware Timer with a period of 'delay' 
-   */
-  if (alt_alarm_start (&alarm,
-        delay,
-        alarm_handler,
-        context) < 0)
-  {
-    printf("No system clock available!n");
-  }
+  /* Calibrate the extra load before any other task can disturb it */
+  load_set_switched_out(switched_out);
+  if (load_calibrate() < 0)
+    printf("No timestamp timer available, ExtraLoad disabled!\n");
+  else
+    printf("ExtraLoad: %lu iterations per ms\n", (unsigned long) load_iterations_per_ms());
 
-  /* 
-   * Create and start Software Timer 
-   */
+  /* Release the periodic tasks every HW_TIMER_PERIOD ms (see tasks.c) */
+  tasks_start_releases();
 
   /*
    * Creation of Kernel Objects
    */
 
-  // Mailboxes
-  Mbox_Throttle = OSMboxCreate((void*) 0); /* Empty Mailbox - Throttle */
-  Mbox_Velocity = OSMboxCreate((void*) 0); /* Empty Mailbox - Velocity */
-  Mbox_Brake = OSMboxCreate((void*) 1); /* Empty Mailbox - Brake */
-  Mbox_Engine = OSMboxCreate((void*) 1); /* Empty Mailbox - Engine */
+  // Throttle and brake commands to the vehicle (see actuator.h)
+  act_init();
+
+  // Telemetry frames, one sample per vehicle step (see telemetry.h)
+  telem_init(VEHICLE_PERIOD * OS_TICKS_PER_SEC / 1000);
+
+  // Mailboxes, carrying blocks of the message pool (see msgpool.h)
+  msgpool_init();
+  Mbox_Engine = OSMboxCreate((void*) 0); /* Empty Mailbox - Engine */
+
+  // Vehicle mode, published as event flags (see vehicle_mode.h)
+  mode_init();
+  Mode_Flags = OSFlagCreate(0, &err);
+
+  // Load shedding, driven by Monitor (see shed.h)
+  shed_init(&shed);
+
+  // Key presses are delivered by the KEY PIO interrupt
+  Buttons_Queue = OSQCreate(Buttons_QueueStorage, BUTTON_EVENTS);
+  buttons_init(Buttons_Queue);
+  input_replay_start();
 
   /*
    * Create statistics task
@@ -824,135 +750,20 @@ void StartTask(void* pdata)
   OSStatInit();
 
   /* 
-   * Creating Tasks in the system 
+   * Creating Tasks in the system (see cruise_tasks.h)
    */
-err = OSTaskCreateExt(
-      ControlTask, // Pointer to task code
-      NULL,        // Pointer to argument that is
-      // passed to task
-      &ControlTask_Stack[TASK_STACKSIZE-1], // Pointer to top
-      // of task stack
-      CONTROLTASK_PRIO,
-      CONTROLTASK_PRIO,
-      (void *)&ControlTask_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt(
-      VehicleTask, // Pointer to task code
-      NULL,        // Pointer to argument that is
-      // passed to task
-      &VehicleTask_Stack[TASK_STACKSIZE-1], // Pointer to top
-      // of task stack
-      VEHICLETASK_PRIO,
-      VEHICLETASK_PRIO,
-      (void *)&VehicleTask_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt(
-      ButtonIO, // Pointer to task code
-      NULL,        // Pointer to argument that is
-      // passed to task
-      &ButtonIO_Stack[TASK_STACKSIZE-1], // Pointer to top
-      // of task stack
-      BUTTONIO_PRIO,
-      BUTTONIO_PRIO,
-      (void *)&ButtonIO_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt(
-      SwitchIO, // Pointer to task code
-      NULL,        // Pointer to argument that is
-      // passed to task
-      &SwitchIO_Stack[TASK_STACKSIZE-1], // Pointer to top
-      // of task stack
-      SWITCHIO_PRIO,
-      SWITCHIO_PRIO,
-      (void *)&SwitchIO_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-
-  err = OSTaskCreateExt(
-      Watchdog, // Pointer to task code
-      NULL,        // Pointer to argument that is
-      // passed to task
-      &Watchdog_Stack[TASK_STACKSIZE-1], // Pointer to top
-      // of task stack
-      WATCHDOG_PRIO,
-      WATCHDOG_PRIO,
-      (void *)&Watchdog_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt(
-      Overload, // Pointer to task code
-      NULL,        // Pointer to argument that is
-      // passed to task
-      &Overload_Stack[TASK_STACKSIZE-1], // Pointer to top
-      // of task stack
-      OVERLOAD_PRIO,
-      OVERLOAD_PRIO,
-      (void *)&Overload_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt(
-      ExtraLoad, // Pointer to task code
-      NULL,        // Pointer to argument that is
-      // passed to task
-      &ExtraLoad_Stack[TASK_STACKSIZE-1], // Pointer to top
-      // of task stack
-      EXTRALOAD_PRIO,
-      EXTRALOAD_PRIO,
-      (void *)&ExtraLoad_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
+  tasks_create();
 
   printf("All Tasks and Kernel Objects generated!\n");
 
+  /* Keep the stack peak of this task for stacks_report() */
+  stacks_sample();
+
   /* Task deletes itself */
 
   OSTaskDel(OS_PRIO_SELF);
 }
 
-void vehicleCallback(){
-  OSSemPost(Vehicle_Semaphore);
-}
-
-void controlCallback(){
-  OSSemPost(Control_Semaphore);
-}
-
-void buttonCallback(){
-  OSSemPost(Buttons_Semaphore);
-}
-
-void switchCallback(){
-  OSSemPost(Switches_Semaphore);
-}
-
-void watchdogCallback(){
-  OSSemPost(Watchdog_Semaphore);
-}
-
-void overloadCallback(){
-  OSSemPost(Overload_Semaphore);
-}
-
-void extraLoadCallback(){
-  OSSemPost(ExtraLoad_Semaphore);
-}
-
 /*
  * The function 'main' creates only a single task 'StartTask' and starts
  * the OS. All other tasks are started from the task 'StartTask'.
@@ -960,92 +771,24 @@ void extraLoadCallback(){
 int main(void) {
   printf("Lab: Cruise Control\n");
 
+  /* Canaries below all task stacks */
+  stacks_init();
+
   OSTaskCreateExt(
       StartTask, // Pointer to task code
       NULL,      // Pointer to argument that is
       // passed to task
-      (void *)&StartTask_Stack[TASK_STACKSIZE-1], // Pointer to top
+      (void *)&StartTask_Stack[STACK_CANARY_WORDS + STACK_START - 1], // Pointer to top
       // of task stack 
       STARTTASK_PRIO,
       STARTTASK_PRIO,
-      (void *)&StartTask_Stack[0],
-      TASK_STACKSIZE,
+      (void *)&StartTask_Stack[STACK_CANARY_WORDS],
+      STACK_START,
       (void *) 0,  
       OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
 
-  Vehicle_Semaphore = OSSemCreate(0);
-  Control_Semaphore = OSSemCreate(0);
-  Buttons_Semaphore = OSSemCreate(0);
-  Switches_Semaphore = OSSemCreate(0);
-  Watchdog_Semaphore = OSSemCreate(0);
-  Overload_Semaphore = OSSemCreate(0);
-  OKSignal_Semaphore = OSSemCreate(0);
-  ExtraLoad_Semaphore = OSSemCreate(0);
-
-  INT8U err; 
-  Vehicle_Timer = OSTmrCreate(0,
-                              VEHICLE_PERIOD * 0.001 * OS_TMR_CFG_TICKS_PER_SEC, // * 0.001 conversion from ms to s
-                              OS_TMR_OPT_PERIODIC,
-                              vehicleCallback,
-                              NULL,
-                              "Vehicle Timer",
-                              &err);
-
-  Control_Timer = OSTmrCreate(0,
-                              CONTROL_PERIOD * 0.001 * OS_TMR_CFG_TICKS_PER_SEC, // * 0.001 conversion from ms to s
-                              OS_TMR_OPT_PERIODIC,
-                              controlCallback,
-                              NULL,
-                              "Control Timer",
-                              &err);
-
-  Buttons_Timer = OSTmrCreate(0,
-                              BUTTONS_PERIOD * 0.001 * OS_TMR_CFG_TICKS_PER_SEC, // * 0.001 conversion from ms to s
-                              OS_TMR_OPT_PERIODIC,
-                              buttonCallback,
-                              NULL,
-                              "Buttons Timer",
-                              &err);
-
-  Switches_Timer = OSTmrCreate(0,
-                              SWITCHES_PERIOD * 0.001 * OS_TMR_CFG_TICKS_PER_SEC, // * 0.001 conversion from ms to s
-                              OS_TMR_OPT_PERIODIC,
-                              switchCallback,
-                              NULL,
-                              "Switches Timer",
-                              &err);
-
-  Watchdog_Timer = OSTmrCreate(0,
-                              WATCHDOG_PERIOD * 0.001 * OS_TMR_CFG_TICKS_PER_SEC, // * 0.001 conversion from ms to s
-                              OS_TMR_OPT_PERIODIC,
-                              watchdogCallback,
-                              NULL,
-                              "Switches Timer",
-                              &err);
-
-  Overload_Timer = OSTmrCreate(0,
-                              OVERLOAD_PERIOD * 0.001 * OS_TMR_CFG_TICKS_PER_SEC, // * 0.001 conversion from ms to s
-                              OS_TMR_OPT_PERIODIC,
-                              overloadCallback,
-                              NULL,
-                              "Switches Timer",
-                              &err);
-
-  ExtraLoad_Timer = OSTmrCreate(0,
-                              EXTRALOAD_PERIOD * 0.001 * OS_TMR_CFG_TICKS_PER_SEC, // * 0.001 conversion from ms to s
-                              OS_TMR_OPT_PERIODIC,
-                              extraLoadCallback,
-                              NULL,
-                              "Switches Timer",
-                              &err);
-
-  OSTmrStart(Vehicle_Timer, &err);
-  OSTmrStart(Control_Timer, &err);
-  OSTmrStart(Buttons_Timer, &err);
-  OSTmrStart(Switches_Timer, &err);
-  OSTmrStart(Watchdog_Timer, &err);
-  OSTmrStart(Overload_Timer, &err);
-  OSTmrStart(ExtraLoad_Timer, &err);
+  /* Release flags and release table of the task table */
+  tasks_create_releases();
 
   OSStart();
 
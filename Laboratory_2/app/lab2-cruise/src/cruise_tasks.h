@@ -0,0 +1,115 @@
+#ifndef CRUISE_TASKS_H_
+#define CRUISE_TASKS_H_
+
+/*
+ * Task set of the cruise control application.
+ *
+ * Every task is one row of CRUISE_TASKS:
+ *
+ *   X(ID, entry, period, phase, prio, stack, wcet, release, crit)
+ *
+ *   ID       short name; generates ID_PERIOD, ID_PRIO, ID_STACKSIZE, ID_WCET
+ *   entry    task function
+ *   period   release period in ms (minimum inter-arrival for events)
+ *   phase    offset of the timer releases in ms, below the period
+ *   prio     uC/OS-II priority, lower is more important
+ *   stack    stack size in OS_STK entries, STACK_<ID> of stack_sizes.h
+ *   wcet     execution time budget in us, an estimate until measured on
+ *            the board (host/rta.c); ExtraLoad is held to it
+ *   release  RELEASE_TIMER: released every period (see tasks.c)
+ *            RELEASE_EVENT: waits on its own event, e.g. an ISR queue
+ *   crit     criticality, what the task gives up under overload (shed.h)
+ *            CRIT_HIGH:        control path, never shed
+ *            CRIT_LOW:         suspended while the system is shedding
+ *            CRIT_BEST_EFFORT: also held to half its wcet budget while
+ *                              the shedding is relaxed
+ *
+ * This header only uses the preprocessor so that host tools can include
+ * it. A task set whose utilisation exceeds the Liu & Layland bound, or
+ * that reuses a priority, does not compile. The bound assumes rate
+ * monotonic priorities, which this set does not have, so it is only a
+ * first filter: host/rta runs the exact response-time analysis of the
+ * table, including blocking and the release overhead.
+ */
+
+#define RELEASE_TIMER 0
+#define RELEASE_EVENT 1
+
+#define CRIT_BEST_EFFORT 0
+#define CRIT_LOW         1
+#define CRIT_HIGH        2
+
+/* 1: release through one OS_TMR per task (see tasks.h) */
+#ifndef RELEASE_OS_TMR
+#define RELEASE_OS_TMR 0
+#endif
+
+/* resolution of the timer releases */
+#if RELEASE_OS_TMR
+#define HW_TIMER_PERIOD 100 /* 100ms */
+#else
+#define HW_TIMER_PERIOD 1   /* 1ms */
+#endif
+
+#define STARTTASK_PRIO  5
+#define TASK_STACKSIZE  2048 /* default, until the stacks have been measured */
+
+#include "stack_sizes.h"
+
+#define CRUISE_TASKS(X)                                                                          \
+  X(MONITOR,   Monitor,     100, 0,  1, STACK_MONITOR,     200, RELEASE_TIMER, CRIT_HIGH)        \
+  X(EXTRALOAD, ExtraLoad,   300, 0,  2, STACK_EXTRALOAD, 15000, RELEASE_TIMER, CRIT_BEST_EFFORT) \
+  X(BUTTONS,   ButtonIO,     20, 0,  7, STACK_BUTTONS,     500, RELEASE_EVENT, CRIT_HIGH)        \
+  X(SWITCHES,  SwitchIO,    300, 0,  8, STACK_SWITCHES,    500, RELEASE_TIMER, CRIT_HIGH)        \
+  X(VEHICLE,   VehicleTask, 300, 0, 10, STACK_VEHICLE,    1000, RELEASE_TIMER, CRIT_HIGH)        \
+  X(CONTROL,   ControlTask, 300, 0, 12, STACK_CONTROL,    1000, RELEASE_TIMER, CRIT_HIGH)        \
+  X(DISPLAY,   DisplayTask, 100, 0, 13, STACK_DISPLAY,     200, RELEASE_TIMER, CRIT_LOW)         \
+  X(LOG,       LogTask,     100, 0, 14, STACK_LOG,        5000, RELEASE_TIMER, CRIT_LOW)
+
+/*
+ * Generated constants: TASK_<ID> is the row index, <ID>_PERIOD,
+ * <ID>_PRIO, <ID>_STACKSIZE and <ID>_WCET the row fields.
+ */
+#define CRUISE_TASK_INDEX(id, entry, period, phase, prio, stack, wcet, release, crit) TASK_##id,
+enum cruise_task_id { CRUISE_TASKS(CRUISE_TASK_INDEX) CRUISE_NUM_TASKS };
+#undef CRUISE_TASK_INDEX
+
+#define CRUISE_TASK_CONSTANTS(id, entry, period, phase, prio, stack, wcet, release, crit) \
+  id##_PERIOD = (period), id##_PRIO = (prio), id##_STACKSIZE = (stack), id##_WCET = (wcet),
+enum cruise_task_constants { CRUISE_TASKS(CRUISE_TASK_CONSTANTS) };
+#undef CRUISE_TASK_CONSTANTS
+
+/*
+ * Compile-time checks
+ */
+#define CRUISE_STATIC_ASSERT(name, cond) typedef char name[(cond) ? 1 : -1]
+
+/* Liu & Layland bound n(2^(1/n) - 1) in ppm, ln 2 for large n */
+#define CRUISE_LL_BOUND(n)                                                    \
+  ((n) <= 1 ? 1000000ULL : (n) == 2 ? 828427ULL : (n) == 3 ? 779763ULL :      \
+   (n) == 4 ? 756828ULL : (n) == 5 ? 743492ULL : (n) == 6 ? 734772ULL :       \
+   (n) == 7 ? 728627ULL : (n) == 8 ? 724062ULL : (n) == 9 ? 720538ULL :       \
+   (n) == 10 ? 717735ULL : 693147ULL)
+
+#define CRUISE_UTIL_PPM(id, entry, period, phase, prio, stack, wcet, release, crit) \
+  + (wcet) * 1000ULL / (period)
+#define CRUISE_PRIO_SUM(id, entry, period, phase, prio, stack, wcet, release, crit) \
+  + (1ULL << (prio))
+#define CRUISE_PRIO_OR(id, entry, period, phase, prio, stack, wcet, release, crit) \
+  | (1ULL << (prio))
+#define CRUISE_PRIO_MAX(id, entry, period, phase, prio, stack, wcet, release, crit) \
+  && (prio) < 64
+#define CRUISE_TIMER_GRID(id, entry, period, phase, prio, stack, wcet, release, crit) \
+  && ((release) != RELEASE_TIMER ||                                           \
+      ((period) % HW_TIMER_PERIOD == 0 && (phase) % HW_TIMER_PERIOD == 0 &&  \
+       (phase) < (period)))
+
+CRUISE_STATIC_ASSERT(cruise_prio_range, 1 CRUISE_TASKS(CRUISE_PRIO_MAX));
+CRUISE_STATIC_ASSERT(cruise_unique_prio,
+                     ((1ULL << STARTTASK_PRIO) CRUISE_TASKS(CRUISE_PRIO_SUM)) ==
+                     ((1ULL << STARTTASK_PRIO) CRUISE_TASKS(CRUISE_PRIO_OR)));
+CRUISE_STATIC_ASSERT(cruise_liu_layland,
+                     (0 CRUISE_TASKS(CRUISE_UTIL_PPM)) <= CRUISE_LL_BOUND(CRUISE_NUM_TASKS));
+CRUISE_STATIC_ASSERT(cruise_timer_grid, 1 CRUISE_TASKS(CRUISE_TIMER_GRID));
+
+#endif /*CRUISE_TASKS_H_*/
@@ -0,0 +1,71 @@
+/*
+ * Shadow registers for the output PIOs.
+ *
+ * display_set() replaces the bits selected by 'mask' in a shadow
+ * register. The read-modify-write is a handful of instructions done with
+ * interrupts disabled, since the Nios II has no atomic RMW instruction.
+ * It never blocks and is safe from any task.
+ *
+ * display_refresh() is called once per frame by DisplayTask. It writes a
+ * PIO only when its shadow differs from the value last written, so every
+ * output register sees at most one bus write per frame.
+ */
+#include "system.h"
+#include "altera_avalon_pio_regs.h"
+#include "display.h"
+
+static const INT32U pio_base[DISPLAY_NUM_REGS] = {
+  DE2_PIO_REDLED18_BASE,
+  DE2_PIO_GREENLED9_BASE,
+  DE2_PIO_HEX_LOW28_BASE,
+  DE2_PIO_HEX_HIGH28_BASE
+};
+
+static volatile INT32U shadow[DISPLAY_NUM_REGS];
+static INT32U written[DISPLAY_NUM_REGS]; /* only used by DisplayTask */
+static INT32U bus_writes = 0;
+
+void display_init(void)
+{
+  int i;
+
+  for (i = 0; i < DISPLAY_NUM_REGS; ++i) {
+    shadow[i] = 0;
+    written[i] = ~shadow[i]; /* force the first frame out */
+  }
+  bus_writes = 0;
+}
+
+void display_set(enum display_reg reg, INT32U mask, INT32U value)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  OS_ENTER_CRITICAL();
+  shadow[reg] = (shadow[reg] & ~mask) | (value & mask);
+  OS_EXIT_CRITICAL();
+}
+
+void display_refresh(void)
+{
+  int i;
+
+  for (i = 0; i < DISPLAY_NUM_REGS; ++i) {
+    INT32U value = shadow[i];
+
+    if (value != written[i]) {
+      IOWR_ALTERA_AVALON_PIO_DATA(pio_base[i], value);
+      written[i] = value;
+      ++bus_writes;
+    }
+  }
+}
+
+/*
+ * Number of PIO writes issued since display_init()
+ */
+INT32U display_bus_writes(void)
+{
+  return bus_writes;
+}
@@ -0,0 +1,31 @@
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include "includes.h"
+
+/*
+ * Output compositor for the LEDs and the seven-segment displays.
+ *
+ * Tasks never touch the output PIOs directly. They update shadow copies
+ * of the registers, and DisplayTask copies every shadow that changed to
+ * its PIO once per frame.
+ */
+
+enum display_reg {
+  DISPLAY_LED_RED,    /* DE2_PIO_REDLED18 */
+  DISPLAY_LED_GREEN,  /* DE2_PIO_GREENLED9 */
+  DISPLAY_HEX_LOW,    /* DE2_PIO_HEX_LOW28 (HEX3..HEX0) */
+  DISPLAY_HEX_HIGH,   /* DE2_PIO_HEX_HIGH28 (HEX7..HEX4) */
+  DISPLAY_NUM_REGS
+};
+
+void   display_init(void);
+void   display_set(enum display_reg reg, INT32U mask, INT32U value);
+void   display_refresh(void);
+INT32U display_bus_writes(void);
+
+#define display_on(reg, mask)     display_set((reg), (mask), (mask))
+#define display_off(reg, mask)    display_set((reg), (mask), 0)
+#define display_write(reg, value) display_set((reg), 0xffffffff, (value))
+
+#endif /*DISPLAY_H_*/
@@ -0,0 +1,17 @@
+/*
+ * Input trace replayed with INPUT_REPLAY set (see input_trace.h).
+ *
+ * One INPUT_EVENT(ms, k|s, value) per recorded change. A dump of
+ * input_trace_dump() is turned into this form with
+ *
+ *   sed -n 's/^\([0-9]*\) \([ks]\) \(.*\)$/INPUT_EVENT(\1, \2, \3)/p' dump.txt > input_replay.h
+ *
+ * The trace below starts the engine in top gear, accelerates, engages
+ * the cruise control and then adds 62 % extra load for a minute.
+ */
+INPUT_EVENT(0, s, 0x00003)
+INPUT_EVENT(1000, k, 0x8)
+INPUT_EVENT(20000, k, 0x8)
+INPUT_EVENT(20500, k, 0x2)
+INPUT_EVENT(60000, s, 0x001f3)
+INPUT_EVENT(120000, s, 0x00003)
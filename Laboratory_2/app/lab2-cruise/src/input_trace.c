@@ -0,0 +1,126 @@
+/*
+ * Input trace ring and replay (see input_trace.h).
+ *
+ * The keys are written from the KEY ISR and the replay alarm, the
+ * switches from SwitchIO, so a record is reserved and filled with
+ * interrupts disabled. That only happens on a change.
+ *
+ * When the ring wraps, the switch level of the overwritten records is
+ * kept in 'base_switches', so the dump of a wrapped ring starts with the
+ * level that was valid at its first record.
+ */
+#include <stdio.h>
+#include "sys/alt_alarm.h"
+#include "input_trace.h"
+#include "buttons.h"
+
+#define INPUT_MASK  (INPUT_TRACE_SIZE - 1)
+#define VALUE_MASK  ((1ul << INPUT_SOURCE_SHIFT) - 1)
+
+typedef char input_ring_check[(INPUT_TRACE_SIZE & INPUT_MASK) == 0 ? 1 : -1];
+
+static input_record_t ring[INPUT_TRACE_SIZE];
+static INT32U head = 0;          /* records written */
+static INT32U base_switches = 0; /* level before the oldest record */
+INT32U input_last[INPUT_NUM_SOURCES];
+
+void input_trace_write(int source, INT32U value)
+{
+  input_record_t* r;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  OS_ENTER_CRITICAL();
+  r = &ring[head & INPUT_MASK];
+  if (head >= INPUT_TRACE_SIZE && (r->value >> INPUT_SOURCE_SHIFT) == INPUT_SWITCHES)
+    base_switches = r->value & VALUE_MASK;
+  r->tick = OSTimeGet();
+  r->value = ((INT32U) source << INPUT_SOURCE_SHIFT) | (value & VALUE_MASK);
+  input_last[source] = value;
+  head++;
+  OS_EXIT_CRITICAL();
+}
+
+void input_trace_dump(void)
+{
+  static input_record_t copy[INPUT_TRACE_SIZE];
+  INT32U n, first, base, i;
+  INT32U ms_per_tick = 1000 / OS_TICKS_PER_SEC;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  /* copy with interrupts disabled, print with interrupts enabled */
+  OS_ENTER_CRITICAL();
+  n = head < INPUT_TRACE_SIZE ? head : INPUT_TRACE_SIZE;
+  first = head - n;
+  base = base_switches;
+  for (i = 0; i < n; ++i)
+    copy[i] = ring[(first + i) & INPUT_MASK];
+  OS_EXIT_CRITICAL();
+
+  printf("# input trace: %lu changes, %lu lost\n", (unsigned long) n,
+         (unsigned long) first);
+  if (n == 0)
+    return;
+  if (first)
+    printf("0 s 0x%lx\n", (unsigned long) base);
+  for (i = 0; i < n; ++i)
+    printf("%lu %c 0x%lx\n", (unsigned long) ((copy[i].tick - copy[0].tick) * ms_per_tick),
+           (copy[i].value >> INPUT_SOURCE_SHIFT) == INPUT_KEYS ? 'k' : 's',
+           (unsigned long) (copy[i].value & VALUE_MASK));
+}
+
+#if INPUT_REPLAY
+
+typedef struct {
+  INT32U ms;
+  int    source;
+  INT32U value;
+} input_event_t;
+
+#define INPUT_k INPUT_KEYS
+#define INPUT_s INPUT_SWITCHES
+#define INPUT_EVENT(ms, cmd, value) { ms, INPUT_##cmd, value },
+static const input_event_t replay[] = {
+#include "input_replay.h"
+};
+#undef INPUT_EVENT
+
+#define REPLAY_EVENTS (sizeof(replay) / sizeof(replay[0]))
+
+static alt_alarm replay_alarm;
+static INT32U replay_ms = 0;
+static unsigned int replay_next = 0;
+static volatile INT32U replay_level = 0;
+
+/* Runs in the system clock ISR once per tick */
+static alt_u32 replay_tick(void* context)
+{
+  const input_event_t* e;
+
+  for (; replay_next < REPLAY_EVENTS && replay[replay_next].ms <= replay_ms; ++replay_next) {
+    e = &replay[replay_next];
+    if (e->source == INPUT_KEYS)
+      buttons_post((INT8U) e->value);
+    else
+      replay_level = e->value;
+  }
+  replay_ms += 1000 / OS_TICKS_PER_SEC;
+  return replay_next < REPLAY_EVENTS ? 1 : 0;
+}
+
+void input_replay_start(void)
+{
+  printf("Replaying %u input events\n", (unsigned int) REPLAY_EVENTS);
+  if (alt_alarm_start(&replay_alarm, 1, replay_tick, NULL) < 0)
+    printf("No system clock available, input replay disabled!\n");
+}
+
+INT32U input_replay_switches(void)
+{
+  return replay_level;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef INPUT_TRACE_H_
+#define INPUT_TRACE_H_
+
+#include "includes.h"
+
+/*
+ * Recorder and replayer of the board inputs.
+ *
+ * input_trace_keys() and input_trace_switches() are called where the
+ * inputs are read: the KEY ISR (accepted presses) and switches_pressed().
+ * A value equal to the previous one of its source costs a load and a
+ * compare. A change is stored as one 8 byte record (OS tick and value)
+ * in a RAM ring that keeps the last INPUT_TRACE_SIZE changes.
+ *
+ * input_trace_dump() prints the ring in the input format of the host
+ * port and host/cruise_sim, relative to the oldest record:
+ *
+ *   <ms> k <mask>     keys pressed (KEY0 = 1)
+ *   <ms> s <value>    switch level
+ *
+ * With INPUT_REPLAY set the trace of input_replay.h is played back
+ * instead: an alarm posts the recorded key presses through the same path
+ * as the KEY ISR and switches_pressed() returns the recorded level, so
+ * the tasks cannot tell a replay from a drive.
+ */
+
+#ifndef INPUT_TRACE
+#define INPUT_TRACE 1
+#endif
+
+#ifndef INPUT_REPLAY
+#define INPUT_REPLAY 0
+#endif
+
+#define INPUT_TRACE_SIZE 256 /* records, power of two */
+
+enum input_source {
+  INPUT_KEYS,
+  INPUT_SWITCHES,
+  INPUT_NUM_SOURCES
+};
+
+typedef struct {
+  INT32U tick;   /* OS tick of the change */
+  INT32U value;  /* source in bit 31, value below */
+} input_record_t;
+
+#define INPUT_SOURCE_SHIFT 31
+
+extern INT32U input_last[INPUT_NUM_SOURCES];
+
+void   input_trace_write(int source, INT32U value);
+void   input_trace_dump(void);
+
+/* Keys are events: every accepted press is recorded */
+static inline void input_trace_keys(INT32U keys)
+{
+#if INPUT_TRACE
+  input_trace_write(INPUT_KEYS, keys);
+#endif
+}
+
+static inline INT32U input_trace_switches(INT32U switches)
+{
+#if INPUT_TRACE
+  if (switches != input_last[INPUT_SWITCHES])
+    input_trace_write(INPUT_SWITCHES, switches);
+#endif
+  return switches;
+}
+
+#if INPUT_REPLAY
+void   input_replay_start(void);
+INT32U input_replay_switches(void);
+#else
+#define input_replay_start()
+#endif
+
+#endif /*INPUT_TRACE_H_*/
@@ -0,0 +1,136 @@
+/*
+ * Busy loop timed by the timestamp timer.
+ *
+ * The loop runs in chunks of about LOAD_CHUNK_MS and reads the timer
+ * after each one, so the load ends within a fraction of a chunk of its
+ * target even when the calibration is off, as on a host whose clock
+ * speed changes. The calibration runs the loop several times and keeps
+ * the fastest run, which is the one least disturbed by interrupts.
+ *
+ * Time the task spends switched out does not count as load; interrupts
+ * that do not switch tasks do.
+ */
+#include "load.h"
+#include "timestamp.h"
+
+#define LOAD_CALIBRATION_MS   10 /* length of one calibration run */
+#define LOAD_CALIBRATION_RUNS 5
+
+static uint32_t iterations_per_ms = 0;
+static uint32_t (*switched_out_time)(void) = 0;
+
+static void burn(uint32_t iterations)
+{
+  volatile uint32_t x = 0;
+
+  while (iterations--)
+    x = x + 1;
+}
+
+static uint32_t time_burn(uint32_t iterations)
+{
+  uint32_t t0 = timestamp_now();
+
+  burn(iterations);
+  return timestamp_now() - t0;
+}
+
+/*
+ * Returns 0 on success and -1 if no timestamp timer is available, in
+ * which case load_run() generates no load.
+ */
+int load_calibrate(void)
+{
+  uint32_t window = timestamp_freq() / 1000 * LOAD_CALIBRATION_MS;
+  uint32_t iterations = 1000;
+  uint32_t best = 0xffffffff;
+  int i;
+
+  if (timestamp_start() < 0)
+    return -1;
+
+  /* grow the run until it spans the calibration window */
+  while (time_burn(iterations) < window && iterations < 0x40000000)
+    iterations <<= 1;
+
+  for (i = 0; i < LOAD_CALIBRATION_RUNS; ++i) {
+    uint32_t elapsed = time_burn(iterations);
+
+    if (elapsed < best)
+      best = elapsed;
+  }
+
+  if (best == 0)
+    best = 1;
+  iterations_per_ms = (uint32_t) ((uint64_t) iterations *
+                                  (timestamp_freq() / 1000) / best);
+  return 0;
+}
+
+/*
+ * Sets the function returning the time stamp ticks the calling task has
+ * spent switched out so far
+ */
+void load_set_switched_out(uint32_t (*switched_out)(void))
+{
+  switched_out_time = switched_out;
+}
+
+static uint32_t switched_out(void)
+{
+  return switched_out_time ? switched_out_time() : 0;
+}
+
+uint32_t load_iterations_per_ms(void)
+{
+  return iterations_per_ms;
+}
+
+/*
+ * Burns 'percent' % of a 'period_ms' window and returns the CPU time
+ * actually burned, in tenths of a percent of the window.
+ */
+uint32_t load_run(uint32_t percent, uint32_t period_ms)
+{
+  return load_run_limited(percent, period_ms, 0);
+}
+
+/*
+ * As load_run(), but before every chunk of LOAD_CHUNK_MS the share of the
+ * window is lowered to what 'limit' returns, if that is less. A share
+ * that is already used up ends the run at once.
+ */
+uint32_t load_run_limited(uint32_t percent, uint32_t period_ms, uint32_t (*limit)(void))
+{
+  uint32_t per_ms = timestamp_freq() / 1000;
+  uint64_t window = (uint64_t) per_ms * period_ms, target, allowed, rest;
+  uint32_t chunk = iterations_per_ms * LOAD_CHUNK_MS;
+  uint32_t t0, out0, wall = 0, burned = 0, n;
+
+  if (percent > 100)
+    percent = 100;
+  if (iterations_per_ms == 0 || window == 0)
+    return 0;
+
+  out0 = switched_out();
+  t0 = timestamp_now();
+  target = window * percent / 100;
+  while (burned < target && wall < window) {
+    if (limit) {
+      allowed = window * limit() / 100;
+      if (allowed < target)
+        target = allowed;
+      if (burned >= target)
+        break;
+    }
+    /* close to the end burn half of what is left at the calibrated
+       speed, so a loop slower than calibrated overshoots only a little */
+    rest = (target - burned) * iterations_per_ms / per_ms;
+    n = rest < 2 * (uint64_t) chunk ? (uint32_t) (rest / 2) + 1 : chunk;
+    burn(n);
+    wall = timestamp_now() - t0;
+    burned = wall - (switched_out() - out0);
+  }
+
+  return (uint32_t) ((uint64_t) burned * 1000 / window);
+}
@@ -0,0 +1,35 @@
+#ifndef LOAD_H_
+#define LOAD_H_
+
+#include <stdint.h>
+
+/*
+ * Calibrated CPU load generator for the ExtraLoad task.
+ *
+ * load_calibrate() measures the speed of the busy loop against the
+ * timestamp timer once at startup. load_run() then spins until it has
+ * run for 'percent' % of a 'period_ms' window by the timestamp timer,
+ * whatever the compiler flags and the speed of the loop are. The
+ * calibration only sizes the chunks the loop is split into.
+ *
+ * The run time is the time since the start less the time the caller
+ * was switched out, as given by the function set with
+ * load_set_switched_out() (none: the caller is never switched out). A
+ * run ends at the end of the window at the latest, so a job that is
+ * preempted for long burns less than asked for; the share returned is
+ * the one actually burned.
+ *
+ * load_run_limited() burns in chunks of LOAD_CHUNK_MS and asks 'limit'
+ * before every chunk how many percent of the window the job may take in
+ * total, so a job can be cut short while it runs (load shedding).
+ */
+
+#define LOAD_CHUNK_MS 1
+
+int      load_calibrate(void);
+void     load_set_switched_out(uint32_t (*switched_out)(void));
+uint32_t load_iterations_per_ms(void);
+uint32_t load_run(uint32_t percent, uint32_t period_ms);
+uint32_t load_run_limited(uint32_t percent, uint32_t period_ms, uint32_t (*limit)(void));
+
+#endif /*LOAD_H_*/
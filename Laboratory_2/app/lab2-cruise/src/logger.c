@@ -0,0 +1,141 @@
+/*
+ * Ring buffer of log records.
+ *
+ * Any task may write. A writer reserves a slot with interrupts disabled
+ * for a few instructions, fills it with interrupts enabled and marks it
+ * ready. The single reader (LogTask) consumes records in order and stops
+ * at a slot that is reserved but not yet ready.
+ *
+ * In binary mode each record goes out as 24 little-endian bytes:
+ * sync (16 bit), id (16 bit), tick (32 bit) and LOG_ARGS arguments.
+ */
+#include <stdio.h>
+#include "includes.h"
+#include "logger.h"
+
+#define LOG_MASK (LOG_RING_SIZE - 1)
+
+typedef char log_ring_check[(LOG_RING_SIZE & LOG_MASK) == 0 ? 1 : -1];
+
+static const char* const log_formats[LOG_NUM_MSGS] = {
+#define LOG_MSG(id, level, format) format,
+#include "logger_msgs.h"
+#undef LOG_MSG
+};
+
+static log_record_t ring[LOG_RING_SIZE];
+static volatile uint32_t head = 0;  /* next slot to reserve */
+static volatile uint32_t tail = 0;  /* next slot to drain */
+static volatile uint32_t dropped = 0;
+static uint32_t dropped_reported = 0;
+
+void log_write(uint16_t id, int32_t a0, int32_t a1, int32_t a2, int32_t a3)
+{
+  log_record_t* r;
+  uint32_t slot;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  OS_ENTER_CRITICAL();
+  if (head - tail >= LOG_RING_SIZE) {
+    ++dropped;
+    OS_EXIT_CRITICAL();
+    return;
+  }
+  slot = head++;
+  OS_EXIT_CRITICAL();
+
+  r = &ring[slot & LOG_MASK];
+  r->id = id;
+  r->time = OSTimeGet();
+  r->arg[0] = a0;
+  r->arg[1] = a1;
+  r->arg[2] = a2;
+  r->arg[3] = a3;
+  __sync_synchronize();
+  r->ready = 1;
+}
+
+#if LOG_BINARY
+static void put16(uint8_t* p, uint32_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+}
+
+static void put32(uint8_t* p, uint32_t v)
+{
+  put16(p, v);
+  put16(p + 2, v >> 16);
+}
+#endif
+
+static void emit(const log_record_t* r)
+{
+#if LOG_BINARY
+  uint8_t buf[8 + 4 * LOG_ARGS];
+  int i;
+
+  put16(buf, LOG_SYNC);
+  put16(buf + 2, r->id);
+  put32(buf + 4, r->time);
+  for (i = 0; i < LOG_ARGS; ++i)
+    put32(buf + 8 + 4 * i, (uint32_t) r->arg[i]);
+  fwrite(buf, sizeof(buf), 1, stdout);
+#else
+  printf("[%lu] ", (unsigned long) r->time);
+  printf(log_format(r->id), (int) r->arg[0], (int) r->arg[1],
+         (int) r->arg[2], (int) r->arg[3]);
+#endif
+}
+
+/*
+ * Emits all ready records and returns how many were emitted
+ */
+int log_drain(void)
+{
+  int n = 0;
+  uint32_t lost;
+
+  while (tail != head) {
+    log_record_t* r = &ring[tail & LOG_MASK];
+
+    if (!r->ready)
+      break;
+    __sync_synchronize();
+    emit(r);
+    r->ready = 0;
+    __sync_synchronize();
+    ++tail;
+    ++n;
+  }
+
+  lost = dropped;
+  if (lost != dropped_reported) {
+    log_record_t r;
+
+    r.id = LOG_DROPPED;
+    r.time = OSTimeGet();
+    r.arg[0] = (int32_t) (lost - dropped_reported);
+    r.arg[1] = r.arg[2] = r.arg[3] = 0;
+    emit(&r);
+    dropped_reported = lost;
+  }
+  if (n)
+    fflush(stdout);
+  return n;
+}
+
+/*
+ * Total number of records dropped because the ring was full
+ */
+uint32_t log_dropped(void)
+{
+  return dropped;
+}
+
+const char* log_format(uint16_t id)
+{
+  return id < LOG_NUM_MSGS ? log_formats[id] : "unknown log message %d %d %d %d\n";
+}
@@ -0,0 +1,67 @@
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+#include <stdint.h>
+
+/*
+ * Deferred logger.
+ *
+ * Tasks push fixed-size binary records (message id and integer arguments)
+ * into a ring buffer with LOG(). The lowest priority LogTask drains the
+ * ring with log_drain() and formats the records, so printf and the JTAG
+ * UART are kept out of the periodic tasks.
+ *
+ * Messages below LOG_LEVEL are removed at compile time. When the ring is
+ * full new records are dropped and counted.
+ */
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+/* 1: emit raw records for host/logdecode, 0: emit text */
+#ifndef LOG_BINARY
+#define LOG_BINARY 0
+#endif
+
+#define LOG_ARGS      4
+#define LOG_RING_SIZE 64 /* records, power of two */
+#define LOG_SYNC      0x4c47
+
+enum log_msg_id {
+#define LOG_MSG(id, level, format) id,
+#include "logger_msgs.h"
+#undef LOG_MSG
+  LOG_NUM_MSGS
+};
+
+enum log_msg_level {
+#define LOG_MSG(id, level, format) id##_LEVEL = level,
+#include "logger_msgs.h"
+#undef LOG_MSG
+};
+
+typedef struct {
+  uint16_t id;
+  uint16_t ready;  /* set once the record is completely written */
+  uint32_t time;   /* OS tick */
+  int32_t  arg[LOG_ARGS];
+} log_record_t;
+
+void     log_write(uint16_t id, int32_t a0, int32_t a1, int32_t a2, int32_t a3);
+int      log_drain(void);
+uint32_t log_dropped(void);
+const char* log_format(uint16_t id);
+
+#define LOG(id, a0, a1, a2, a3)                    \
+  do {                                             \
+    if (id##_LEVEL >= LOG_LEVEL)                   \
+      log_write((id), (a0), (a1), (a2), (a3));     \
+  } while (0)
+
+#endif /*LOGGER_H_*/
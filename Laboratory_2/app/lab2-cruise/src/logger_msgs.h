@@ -0,0 +1,22 @@
+/*
+ * Log message table, shared by the target and the host decoder.
+ *
+ * LOG_MSG(id, level, format)
+ *
+ * Every record carries up to LOG_ARGS integer arguments, which are
+ * substituted into 'format' when the record is emitted. The position of
+ * a message in this list is its id on the wire, so only ever append.
+ */
+LOG_MSG(LOG_DROPPED,        LOG_LEVEL_WARN,  "%d log records dropped\n")
+LOG_MSG(LOG_VEHICLE_STATE,  LOG_LEVEL_INFO,  "Position: %d m, Velocity: %d m/s, Accell: %d m/s2, Throttle: %d V\n")
+LOG_MSG(LOG_TARGET_VEL,     LOG_LEVEL_DEBUG, "Target velocity: %d\n")
+LOG_MSG(LOG_EXTRA_LOAD,     LOG_LEVEL_INFO,  "Desired utilization %d %%, achieved %d.%d %%\n")
+LOG_MSG(LOG_OVERLOAD,       LOG_LEVEL_WARN,  "OVERLOADED! utilization %d.%d %%\n")
+LOG_MSG(LOG_OVERLOAD_CLEAR, LOG_LEVEL_INFO,  "Overload cleared, utilization %d.%d %%\n")
+LOG_MSG(LOG_UTIL_HISTORY,   LOG_LEVEL_INFO,  "  utilization history: %d %d %d %d %%\n")
+LOG_MSG(LOG_BUTTON_EVENT,   LOG_LEVEL_DEBUG, "Keys %x handled %d timestamp ticks after the press\n")
+LOG_MSG(LOG_RELEASE_OVERHEAD, LOG_LEVEL_INFO, "Release overhead: %d ns mean, %d ns max per release tick, %d ns per empty tick (OS_TMR %d)\n")
+LOG_MSG(LOG_STACK_OVERFLOW, LOG_LEVEL_ERROR, "Stack overflow of the task with priority %d\n")
+LOG_MSG(LOG_ACT_LOST,       LOG_LEVEL_WARN,  "Actuator command %d (value %d) lost, queue full\n")
+LOG_MSG(LOG_MODE_CHANGE,    LOG_LEVEL_INFO,  "Mode event %d: %02x -> %02x\n")
+LOG_MSG(LOG_SHED,           LOG_LEVEL_WARN,  "Load shedding level %d -> %d, headroom %d %%, %d jobs at risk\n")
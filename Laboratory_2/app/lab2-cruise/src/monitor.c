@@ -0,0 +1,99 @@
+/*
+ * Idle-counter based utilisation monitor.
+ *
+ * A sample costs one interrupts-off read of the idle counter and one
+ * division, so it can run every window from the highest priority task.
+ * The calibration must run before the application tasks are started.
+ */
+#include <stdio.h>
+#include "monitor.h"
+
+static volatile INT32U idle_ctr = 0; /* idle task passes, only it writes */
+static INT32U idle_max = 1;   /* idle counts in one window on an idle CPU */
+static INT32U idle_last = 0;  /* idle_ctr at the end of the last window */
+static int idle_hooked = 0;   /* the idle hook counted during monitor_init() */
+static INT16U history[MONITOR_HISTORY];
+static int history_head = 0;
+static int history_count = 0;
+
+static INT32U idle_count(void)
+{
+  INT32U count;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  OS_ENTER_CRITICAL();
+  count = idle_ctr;
+  OS_EXIT_CRITICAL();
+  return count;
+}
+
+/*
+ * Counts one pass of the idle task, called from App_TaskIdleHook()
+ */
+void monitor_idle(void)
+{
+  idle_ctr++;
+}
+
+/*
+ * Blocks the calling task for one window of 'window_ticks' OS ticks while
+ * measuring the idle counts of an idle CPU.
+ */
+void monitor_init(INT16U window_ticks)
+{
+  INT32U start;
+
+  OSTimeDly(1); /* start on a tick boundary */
+  start = idle_count();
+  OSTimeDly(window_ticks);
+  idle_last = idle_count();
+  idle_max = idle_last - start;
+  idle_hooked = idle_max != 0;
+  if (!idle_hooked) {
+    printf("Idle hook not called (OS_APP_HOOKS_EN), utilisation not measured!\n");
+    idle_max = 1;
+  }
+  history_head = 0;
+  history_count = 0;
+}
+
+/*
+ * Closes the current window and returns its utilisation
+ */
+INT16U monitor_sample(void)
+{
+  INT32U now = idle_count();
+  INT32U idle = now - idle_last;
+  INT16U util;
+
+  idle_last = now;
+  if (!idle_hooked || idle >= idle_max)
+    util = 0;
+  else
+    util = (INT16U) (1000 - idle * 1000 / idle_max);
+
+  history[history_head] = util;
+  history_head = (history_head + 1) % MONITOR_HISTORY;
+  if (history_count < MONITOR_HISTORY)
+    ++history_count;
+
+  return util;
+}
+
+/*
+ * Copies up to 'n' past utilisation samples, oldest first, to 'out' and
+ * returns how many were copied.
+ */
+int monitor_history(INT16U* out, int n)
+{
+  int i, first;
+
+  if (n > history_count)
+    n = history_count;
+  first = (history_head + MONITOR_HISTORY - n) % MONITOR_HISTORY;
+  for (i = 0; i < n; ++i)
+    out[i] = history[(first + i) % MONITOR_HISTORY];
+  return n;
+}
@@ -0,0 +1,29 @@
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+#include "includes.h"
+
+/*
+ * CPU utilisation monitor based on the idle task.
+ *
+ * The uC/OS-II idle task calls the application idle hook on every pass
+ * of its loop (App_TaskIdleHook(), OS_APP_HOOKS_EN), which counts the
+ * pass with monitor_idle(). OSIdleCtr is not used: the statistics task
+ * clears it every 100 ms once OSStatInit() has run. monitor_init()
+ * measures how far the private counter gets in one window on an idle
+ * CPU. monitor_sample() then turns the counts of the last window into a
+ * utilisation figure. app_hooks.c does not build without
+ * OS_APP_HOOKS_EN; if a port still never calls the hook, monitor_init()
+ * says so and every window reads as idle.
+ *
+ * Utilisation is in tenths of a percent.
+ */
+
+#define MONITOR_HISTORY 16 /* windows kept for reporting */
+
+void   monitor_idle(void);
+void   monitor_init(INT16U window_ticks);
+INT16U monitor_sample(void);
+int    monitor_history(INT16U* out, int n);
+
+#endif /*MONITOR_H_*/
@@ -0,0 +1,85 @@
+/*
+ * Message pool (see msgpool.h).
+ *
+ * Besides the partition itself, the pool counts the blocks in use and
+ * keeps their high-water mark, so that MSG_POOL_SIZE can be checked
+ * against a real run.
+ */
+#include <stdio.h>
+#include "msgpool.h"
+
+static msg_t pool_blocks[MSG_POOL_SIZE];
+static OS_MEM* pool;
+
+static INT32U seq = 0;
+static INT32U used = 0;
+static INT32U used_max = 0;
+static INT32U failures = 0;
+
+void msgpool_init(void)
+{
+  INT8U err;
+
+  pool = OSMemCreate(pool_blocks, MSG_POOL_SIZE, sizeof(msg_t), &err);
+  if (err != OS_NO_ERR)
+    printf("Message pool not created (%d)!\n", err);
+}
+
+INT8U msg_send(OS_EVENT* mbox, INT32S value)
+{
+  msg_t* msg;
+  INT8U err;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  msg = (msg_t*) OSMemGet(pool, &err);
+  OS_ENTER_CRITICAL();
+  if (!msg) {
+    ++failures;
+    OS_EXIT_CRITICAL();
+    return err;
+  }
+  msg->seq = seq++;
+  if (++used > used_max)
+    used_max = used;
+  OS_EXIT_CRITICAL();
+
+  msg->value = value;
+  msg->tick = OSTimeGet();
+  err = OSMboxPost(mbox, (void*) msg);
+  if (err != OS_NO_ERR)
+    msg_free(msg);
+  return err;
+}
+
+/*
+ * Takes the message of 'mbox' without waiting, like OSMboxAccept().
+ * Returns the message, which the caller now owns, or NULL if the mailbox
+ * is empty.
+ */
+msg_t* msg_accept(OS_EVENT* mbox)
+{
+  return (msg_t*) OSMboxAccept(mbox);
+}
+
+void msg_free(msg_t* msg)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  if (OSMemPut(pool, (void*) msg) != OS_NO_ERR)
+    return;
+  OS_ENTER_CRITICAL();
+  --used;
+  OS_EXIT_CRITICAL();
+}
+
+void msgpool_report(void)
+{
+  printf("Message pool: %d blocks of %d bytes, %lu in use, at most %lu, "
+         "%lu sent, %lu allocation failures\n", MSG_POOL_SIZE, (int) sizeof(msg_t),
+         (unsigned long) used, (unsigned long) used_max, (unsigned long) seq,
+         (unsigned long) failures);
+}
@@ -0,0 +1,38 @@
+#ifndef MSGPOOL_H_
+#define MSGPOOL_H_
+
+#include "includes.h"
+
+/*
+ * Fixed-block pool for mailbox messages.
+ *
+ * Messages are copies, not pointers to the locals of the sender.
+ * msg_send() takes a block from the pool, fills in the value, a sequence
+ * number and the OS tick, and posts it. A posted block belongs to the
+ * receiver, which returns it with msg_free() once it has read it. If the
+ * post fails (mailbox full), msg_send() frees the block again and the
+ * sender keeps its value.
+ *
+ * The pool is an OSMem partition of MSG_POOL_SIZE blocks, so taking and
+ * returning a block is constant time and never touches the heap. Only
+ * Mbox_Engine uses it: at most one block waits in the mailbox, one is
+ * held by VehicleTask between msg_accept() and msg_free(), and one is
+ * taken by a msg_send() of SwitchIO that finds the mailbox full and
+ * frees it again. Three blocks are enough; one more is spare.
+ */
+
+#define MSG_POOL_SIZE 4 /* blocks */
+
+typedef struct {
+  INT32S value;
+  INT32U seq;   /* sending order over the whole pool */
+  INT32U tick;  /* OS tick of sending */
+} msg_t;
+
+void   msgpool_init(void);
+INT8U  msg_send(OS_EVENT* mbox, INT32S value);
+msg_t* msg_accept(OS_EVENT* mbox);
+void   msg_free(msg_t* msg);
+void   msgpool_report(void);
+
+#endif /*MSGPOOL_H_*/
@@ -0,0 +1,67 @@
+/*
+ * Profiling sections (see prof.h).
+ */
+#include <stdio.h>
+#include "prof.h"
+
+prof_section_t prof_sections[PROF_NUM_SECTIONS];
+volatile uint32_t prof_preemptions[OS_LOWEST_PRIO + 1];
+volatile uint32_t prof_switched_out[OS_LOWEST_PRIO + 1];
+
+static uint32_t switch_time[OS_LOWEST_PRIO + 1]; /* when the task was switched out */
+
+static const char* const prof_names[PROF_NUM_SECTIONS] = {
+#define PROF_SECTION(id, name) name,
+#include "prof_sections.h"
+#undef PROF_SECTION
+};
+
+/*
+ * Called by the task switch hook before every switch, from OSPrioCur to
+ * OSPrioHighRdy. The current task still runs at a lower priority than
+ * the next one only if it was preempted; a task that blocks always gives
+ * way to a lower priority. The time from its switch out to its next
+ * switch in is added to the switched-out time of the task.
+ */
+void prof_task_switch(void)
+{
+  uint32_t now = timestamp_now();
+
+  if (OSPrioHighRdy < OSPrioCur)
+    prof_preemptions[OSPrioCur]++;
+  switch_time[OSPrioCur] = now;
+  if (switch_time[OSPrioHighRdy])
+    prof_switched_out[OSPrioHighRdy] += now - switch_time[OSPrioHighRdy];
+}
+
+static unsigned long to_us(uint64_t stamps)
+{
+  uint32_t freq = timestamp_freq();
+
+  return freq ? (unsigned long) (stamps * 1000000u / freq) : 0;
+}
+
+/*
+ * Prints one line per section: runs, preempted runs, the mean and
+ * maximum in time stamp ticks (CPU cycles on the target) and in us, and
+ * the maximum of the preempted runs in us.
+ * Sections may be updated while the table is printed, so a line can mix
+ * two consecutive runs.
+ */
+void prof_report(void)
+{
+  const prof_section_t* s;
+  uint64_t mean;
+  int i;
+
+  printf("%-38s %8s %6s %10s %10s %8s %8s %8s\n", "section", "runs", "preem",
+         "mean", "max", "mean us", "max us", "preem us");
+  for (i = 0; i < PROF_NUM_SECTIONS; ++i) {
+    s = &prof_sections[i];
+    mean = s->count ? s->total / s->count : 0;
+    printf("%-38s %8lu %6lu %10lu %10lu %8lu %8lu %8lu\n", prof_names[i],
+           (unsigned long) s->count, (unsigned long) s->preempted,
+           (unsigned long) mean, (unsigned long) s->max,
+           to_us(mean), to_us(s->max), to_us(s->max_preempted));
+  }
+}
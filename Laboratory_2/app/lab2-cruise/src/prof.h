@@ -0,0 +1,96 @@
+#ifndef PROF_H_
+#define PROF_H_
+
+#include <stdint.h>
+#include "includes.h"
+#include "timestamp.h"
+
+/*
+ * Named profiling sections.
+ *
+ * PROF_BEGIN(id) and PROF_END(id) time one run of a section with the
+ * timestamp timer; the sections are listed in prof_sections.h. Every
+ * section keeps its own run count, mean and maximum, so any number of
+ * them can be measured at the same time, unlike the single global
+ * interval of PERF_START_MEASURING on the performance counter.
+ *
+ * The task switch hook (App_TaskSwHook()) adds up, per task, the time
+ * the task is switched out, and a run is charged its wall time less the
+ * switched-out time within it. So runs during which the task was
+ * preempted or blocked (e.g. a pend with a timeout) enter mean and
+ * maximum with the time the task itself ran; interrupts that do not
+ * switch tasks are part of the measurement. Runs with a switch to a
+ * higher priority task are counted as 'preempted' and have their own
+ * maximum, to check that the longest runs are not only the preempted
+ * ones.
+ *
+ * A section must not be entered by two tasks at a time. With PROF_ENABLE
+ * set to 0 the macros compile to nothing.
+ */
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 1
+#endif
+
+enum prof_section_id {
+#define PROF_SECTION(id, name) id,
+#include "prof_sections.h"
+#undef PROF_SECTION
+  PROF_NUM_SECTIONS
+};
+
+typedef struct {
+  uint32_t start;     /* time stamp of the current run */
+  uint32_t out;       /* switched-out time of the task at the start */
+  uint32_t switches;  /* preemption count of the task at the start */
+  uint32_t count;     /* runs */
+  uint32_t preempted; /* runs with a preemption */
+  uint32_t max;
+  uint32_t max_preempted;
+  uint64_t total;
+} prof_section_t;
+
+extern prof_section_t prof_sections[PROF_NUM_SECTIONS];
+/* by priority, updated by the task switch hook */
+extern volatile uint32_t prof_preemptions[OS_LOWEST_PRIO + 1];
+extern volatile uint32_t prof_switched_out[OS_LOWEST_PRIO + 1]; /* time stamp ticks */
+
+static inline void prof_begin(int id)
+{
+  prof_section_t* s = &prof_sections[id];
+
+  s->switches = prof_preemptions[OSPrioCur];
+  s->out = prof_switched_out[OSPrioCur];
+  s->start = timestamp_now();
+}
+
+static inline void prof_end(int id)
+{
+  prof_section_t* s = &prof_sections[id];
+  uint32_t t = timestamp_now() - s->start;
+
+  /* the task runs, so its switched-out time does not change meanwhile */
+  t -= prof_switched_out[OSPrioCur] - s->out;
+  s->count++;
+  s->total += t;
+  if (t > s->max)
+    s->max = t;
+  if (prof_preemptions[OSPrioCur] != s->switches) {
+    s->preempted++;
+    if (t > s->max_preempted)
+      s->max_preempted = t;
+  }
+}
+
+#if PROF_ENABLE
+#define PROF_BEGIN(id) prof_begin(id)
+#define PROF_END(id)   prof_end(id)
+#else
+#define PROF_BEGIN(id)
+#define PROF_END(id)
+#endif
+
+void prof_task_switch(void);
+void prof_report(void);
+
+#endif /*PROF_H_*/
@@ -0,0 +1,19 @@
+/*
+ * Profiling sections.
+ *
+ * PROF_SECTION(id, name)
+ *
+ * Task bodies are named after their entry function as in cruise_tasks.h,
+ * so their maxima can be passed to host/rta as measured WCETs.
+ */
+PROF_SECTION(PROF_VEHICLE,   "VehicleTask")
+PROF_SECTION(PROF_CONTROL,   "ControlTask")
+PROF_SECTION(PROF_BUTTONS,   "ButtonIO")
+PROF_SECTION(PROF_SWITCHES,  "SwitchIO")
+PROF_SECTION(PROF_MONITOR,   "Monitor")
+PROF_SECTION(PROF_EXTRALOAD, "ExtraLoad")
+PROF_SECTION(PROF_DISPLAY,   "DisplayTask")
+PROF_SECTION(PROF_LOG,       "LogTask")
+PROF_SECTION(PROF_PI_STEP,   "pi_step")
+PROF_SECTION(PROF_POSITION,  "show_position")
+PROF_SECTION(PROF_UTIL_SW,   "get_desired_utilization_from_switches")
@@ -0,0 +1,90 @@
+/*
+ * Release jitter and response time statistics (see rtstats.h).
+ */
+#include <stdio.h>
+#include "rtstats.h"
+#include "timestamp.h"
+
+static void hist_init(rt_hist_t* h)
+{
+  int i;
+
+  h->count = 0;
+  h->min = UINT32_MAX;
+  h->max = 0;
+  h->total = 0;
+  for (i = 0; i < RTSTATS_BUCKETS; ++i)
+    h->bucket[i] = 0;
+}
+
+static void hist_add(rt_hist_t* h, uint32_t stamps)
+{
+  uint32_t per_us = timestamp_freq() / 1000000;
+  uint32_t us = per_us ? stamps / per_us : stamps;
+  uint32_t v = us >> 1;
+  int b = 0;
+
+  while (v && b < RTSTATS_BUCKETS - 1) {
+    v >>= 1;
+    ++b;
+  }
+
+  h->count++;
+  h->total += us;
+  if (us < h->min) h->min = us;
+  if (us > h->max) h->max = us;
+  h->bucket[b]++;
+}
+
+void rtstats_init(rt_stats_t* s)
+{
+  s->release = 0;
+  s->started = 0;
+  s->waiting = 0;
+  hist_init(&s->jitter);
+  hist_init(&s->response);
+}
+
+void rtstats_release(rt_stats_t* s, uint32_t stamp)
+{
+  s->release = stamp;
+  s->waiting = 1;
+}
+
+void rtstats_start(rt_stats_t* s, uint32_t stamp)
+{
+  hist_add(&s->jitter, stamp - s->release);
+  s->started = 1;
+  s->waiting = 0;
+}
+
+void rtstats_complete(rt_stats_t* s, uint32_t stamp)
+{
+  if (!s->started)
+    return;
+  hist_add(&s->response, stamp - s->release);
+  s->started = 0;
+}
+
+static void hist_print(const char* what, const rt_hist_t* h)
+{
+  int i;
+
+  if (h->count == 0) {
+    printf("  %-8s no samples\n", what);
+    return;
+  }
+  printf("  %-8s n %lu min %lu avg %lu max %lu us\n", what,
+         (unsigned long) h->count, (unsigned long) h->min,
+         (unsigned long) (h->total / h->count), (unsigned long) h->max);
+  for (i = 0; i < RTSTATS_BUCKETS; ++i)
+    if (h->bucket[i])
+      printf("    < %8lu us: %lu\n", 2ul << i, (unsigned long) h->bucket[i]);
+}
+
+void rtstats_print(const char* name, const rt_stats_t* s)
+{
+  printf("%s\n", name);
+  hist_print("jitter", &s->jitter);
+  hist_print("response", &s->response);
+}
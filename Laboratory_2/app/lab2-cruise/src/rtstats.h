@@ -0,0 +1,45 @@
+#ifndef RTSTATS_H_
+#define RTSTATS_H_
+
+#include <stdint.h>
+
+/*
+ * Release jitter and response time statistics of periodic jobs.
+ *
+ * Every job is stamped three times with timestamp_now(): when it is
+ * released (in the release path), when it starts (its task returns from
+ * the pend) and when it completes (its task pends again). The jitter is
+ * start - release, the response time completion - release. Both are
+ * kept in us as min/avg/max and as a histogram with power of two
+ * buckets: bucket 0 counts 0-1 us, bucket i counts [2^i, 2^(i+1)) us.
+ *
+ * Only integer arithmetic on 32-bit time stamps is used, so a host build
+ * with the clock_gettime time stamps of timestamp.h prints the same
+ * report.
+ */
+
+#define RTSTATS_BUCKETS 24 /* up to ~16 s */
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t bucket[RTSTATS_BUCKETS];
+} rt_hist_t;
+
+typedef struct {
+  uint32_t  release;  /* time stamp of the last release */
+  uint32_t  started;  /* a job is running */
+  uint32_t  waiting;  /* a job is released but has not started */
+  rt_hist_t jitter;   /* us */
+  rt_hist_t response; /* us */
+} rt_stats_t;
+
+void rtstats_init(rt_stats_t* s);
+void rtstats_release(rt_stats_t* s, uint32_t stamp);
+void rtstats_start(rt_stats_t* s, uint32_t stamp);
+void rtstats_complete(rt_stats_t* s, uint32_t stamp);
+void rtstats_print(const char* name, const rt_stats_t* s);
+
+#endif /*RTSTATS_H_*/
@@ -0,0 +1,25 @@
+/*
+ * Seven-segment table (see sevenseg.h).
+ */
+#include "sevenseg.h"
+
+const uint8_t sevenseg_digits[10] = {
+  0x40, 0x79, 0x24, 0x30, 0x19, 0x12, 0x02, 0x78, 0x00, 0x18
+};
+
+uint32_t sevenseg_table[SEVENSEG_MAX - SEVENSEG_MIN + 1];
+
+/* runs once, so the divisions by 10 are paid here only */
+void sevenseg_init(void)
+{
+  int value, magnitude, digit;
+  uint32_t word;
+
+  for (value = SEVENSEG_MIN; value <= SEVENSEG_MAX; ++value) {
+    magnitude = value < 0 ? -value : value;
+    word = value < 0 ? SEVENSEG_MINUS : sevenseg_digits[0];
+    for (digit = 100; digit > 0; digit /= 10)
+      word = (word << SEVENSEG_BITS) | sevenseg_digits[(magnitude / digit) % 10];
+    sevenseg_table[value - SEVENSEG_MIN] = word;
+  }
+}
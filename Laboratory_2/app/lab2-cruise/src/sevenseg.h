@@ -0,0 +1,34 @@
+#ifndef SEVENSEG_H_
+#define SEVENSEG_H_
+
+#include <stdint.h>
+
+/*
+ * Seven-segment encoding of signed numbers.
+ *
+ * A number is shown on four digits of one HEX PIO register (7 bits per
+ * digit, active low, rightmost digit in the low bits): the sign ('-' or
+ * '0') followed by three decimal digits. sevenseg_init() encodes every
+ * value from SEVENSEG_MIN to SEVENSEG_MAX once, so sevenseg_word() is a
+ * table lookup with no division. Values out of range are clamped.
+ */
+
+#define SEVENSEG_MIN  (-999)
+#define SEVENSEG_MAX  999
+#define SEVENSEG_BITS 7 /* per digit */
+
+#define SEVENSEG_MINUS 0x3f /* segment g only */
+
+extern const uint8_t sevenseg_digits[10];
+extern uint32_t      sevenseg_table[SEVENSEG_MAX - SEVENSEG_MIN + 1];
+
+void sevenseg_init(void);
+
+static inline uint32_t sevenseg_word(int value)
+{
+  if (value < SEVENSEG_MIN) value = SEVENSEG_MIN;
+  if (value > SEVENSEG_MAX) value = SEVENSEG_MAX;
+  return sevenseg_table[value - SEVENSEG_MIN];
+}
+
+#endif /*SEVENSEG_H_*/
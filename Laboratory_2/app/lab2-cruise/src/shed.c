@@ -0,0 +1,45 @@
+/*
+ * Load shedding policy (see shed.h).
+ */
+#include "shed.h"
+
+void shed_init(shed_t* s)
+{
+  s->level = SHED_NONE;
+  s->calm = 0;
+  s->hold = SHED_HOLD_MIN;
+  s->settled = SHED_HOLD_MAX;
+  s->switches = 0;
+}
+
+/*
+ * Returns the level for the next window
+ */
+int shed_update(shed_t* s, int overloaded, int calm)
+{
+  if (s->settled < SHED_HOLD_MAX)
+    s->settled++;
+
+  if (overloaded) {
+    s->calm = 0;
+    if (s->level != SHED_SUSPEND) {
+      /* the last step back came too early */
+      if (s->settled < s->hold && s->hold < SHED_HOLD_MAX)
+        s->hold *= 2;
+      s->level = SHED_SUSPEND;
+      s->switches++;
+    }
+    return s->level;
+  }
+
+  s->calm = calm ? s->calm + 1 : 0;
+  if (s->level != SHED_NONE && s->calm >= s->hold) {
+    s->level--;
+    s->calm = 0;
+    s->settled = 0;
+    s->switches++;
+  } else if (s->level == SHED_NONE && s->settled == SHED_HOLD_MAX) {
+    s->hold = SHED_HOLD_MIN;
+  }
+  return s->level;
+}
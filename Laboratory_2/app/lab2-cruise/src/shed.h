@@ -0,0 +1,72 @@
+#ifndef SHED_H_
+#define SHED_H_
+
+#include <stdint.h>
+#include "cruise_tasks.h"
+
+/*
+ * Load shedding policy.
+ *
+ * Monitor calls shed_update() once per window with two verdicts: the
+ * system is overloaded (a CRIT_HIGH job is at risk of missing its
+ * deadline, or the headroom over the longest period is below the
+ * threshold) or calm (headroom well above the threshold). The level it
+ * returns says what the tasks of the table give up, by criticality
+ * (CRIT_* of cruise_tasks.h):
+ *
+ *   SHED_NONE      all tasks run as specified
+ *   SHED_THROTTLE  CRIT_BEST_EFFORT tasks are held to half their wcet budget
+ *   SHED_SUSPEND   CRIT_BEST_EFFORT and CRIT_LOW tasks are suspended
+ *
+ * Overload moves straight to SHED_SUSPEND, so the control path gets the
+ * CPU back within one window. The way back is one level at a time, each
+ * after 'hold' calm windows in a row. An overload soon after a step back
+ * doubles 'hold' (up to SHED_HOLD_MAX), so a load that does not fit is
+ * retried less and less often. A long stretch at SHED_NONE resets it.
+ *
+ * This module only uses <stdint.h> and the task table, so
+ * host/cruise_sim runs the same policy.
+ */
+
+enum shed_level {
+  SHED_NONE,
+  SHED_THROTTLE,
+  SHED_SUSPEND,
+  SHED_NUM_LEVELS
+};
+
+#define SHED_HYSTERESIS 200  /* calm: headroom above the threshold by 20 % */
+#define SHED_HOLD_MIN   10   /* windows */
+#define SHED_HOLD_MAX   640  /* windows */
+
+typedef struct {
+  uint8_t  level;
+  uint16_t calm;     /* calm windows in a row */
+  uint16_t hold;     /* calm windows needed to step back */
+  uint16_t settled;  /* windows since the last step back */
+  uint32_t switches; /* level changes */
+} shed_t;
+
+void shed_init(shed_t* s);
+int  shed_update(shed_t* s, int overloaded, int calm);
+
+/* what a task of criticality 'crit' gives up at 'level' */
+static inline int shed_suspends(int level, int crit)
+{
+  return level >= SHED_SUSPEND && crit < CRIT_HIGH;
+}
+
+static inline int shed_throttles(int level, int crit)
+{
+  return level >= SHED_THROTTLE && crit == CRIT_BEST_EFFORT;
+}
+
+/* execution time a task with budget 'wcet' may take at 'level' */
+static inline uint32_t shed_budget(int level, int crit, uint32_t wcet)
+{
+  if (shed_suspends(level, crit))
+    return 0;
+  return shed_throttles(level, crit) ? wcet / 2 : wcet;
+}
+
+#endif /*SHED_H_*/
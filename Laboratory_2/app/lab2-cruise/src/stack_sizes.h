@@ -0,0 +1,20 @@
+/*
+ * Stack sizes of the cruise tasks in OS_STK entries (see stacks.h).
+ *
+ * The KEY0 report of the board prints these lines with the measured
+ * peak of every task plus STACK_MARGIN. Drive (or replay) the worst-case
+ * inputs for a while, then regenerate this file with
+ *
+ *   nios2-terminal | grep '^#define STACK_' > src/stack_sizes.h
+ *
+ * Until it has been measured every task gets TASK_STACKSIZE.
+ */
+#define STACK_START     TASK_STACKSIZE
+#define STACK_MONITOR   TASK_STACKSIZE
+#define STACK_EXTRALOAD TASK_STACKSIZE
+#define STACK_BUTTONS   TASK_STACKSIZE
+#define STACK_SWITCHES  TASK_STACKSIZE
+#define STACK_VEHICLE   TASK_STACKSIZE
+#define STACK_CONTROL   TASK_STACKSIZE
+#define STACK_DISPLAY   TASK_STACKSIZE
+#define STACK_LOG       TASK_STACKSIZE
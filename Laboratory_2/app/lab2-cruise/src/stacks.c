@@ -0,0 +1,121 @@
+/*
+ * Stack canaries and high-water marks (see stacks.h).
+ *
+ * Row 0 is StartTask, row i + 1 is task i of the task table.
+ */
+#include <stdio.h>
+#include "stacks.h"
+#include "tasks.h"
+#include "logger.h"
+
+#define STACK_ROWS     (CRUISE_NUM_TASKS + 1)
+#define STACK_ROUND    8 /* OS_STK entries */
+
+typedef struct {
+  const char* id;   /* STACK_<id> in stack_sizes.h */
+  const char* name;
+  INT8U       prio;
+  INT32U      size; /* OS_STK entries */
+} stack_row_t;
+
+#define CRUISE_STACK_ROW(id, entry, period, phase, prio, stack, wcet, release, crit) \
+  { #id, #entry, prio, stack },
+static const stack_row_t rows[STACK_ROWS] = {
+  { "START", "StartTask", STARTTASK_PRIO, STACK_START },
+  CRUISE_TASKS(CRUISE_STACK_ROW)
+};
+#undef CRUISE_STACK_ROW
+
+static INT32U peak[STACK_ROWS]; /* bytes */
+static INT8U overflowed[STACK_ROWS];
+
+/* lowest entry that uC/OS-II was given, the canary is right below */
+static OS_STK* stack_bottom(int row)
+{
+  return row == 0 ? &StartTask_Stack[STACK_CANARY_WORDS] : tasks[row - 1].stack;
+}
+
+void stacks_init(void)
+{
+  OS_STK* canary;
+  int i, j;
+
+  for (i = 0; i < STACK_ROWS; ++i) {
+    canary = stack_bottom(i) - STACK_CANARY_WORDS;
+    for (j = 0; j < STACK_CANARY_WORDS; ++j)
+      canary[j] = (OS_STK) STACK_CANARY;
+  }
+}
+
+/*
+ * Returns the number of overflowed stacks. Each overflow is logged once.
+ */
+int stacks_check(void)
+{
+  OS_STK* canary;
+  int i, j, n = 0;
+
+  for (i = 0; i < STACK_ROWS; ++i) {
+    if (!overflowed[i]) {
+      canary = stack_bottom(i) - STACK_CANARY_WORDS;
+      for (j = 0; j < STACK_CANARY_WORDS; ++j)
+        if (canary[j] != (OS_STK) STACK_CANARY) {
+          overflowed[i] = 1;
+          LOG(LOG_STACK_OVERFLOW, rows[i].prio, 0, 0, 0);
+          break;
+        }
+    }
+    n += overflowed[i];
+  }
+  return n;
+}
+
+/*
+ * Updates the peak of every task that still exists
+ */
+void stacks_sample(void)
+{
+  OS_STK_DATA data;
+  int i;
+
+  for (i = 0; i < STACK_ROWS; ++i)
+    if (OSTaskStkChk(rows[i].prio, &data) == OS_NO_ERR && data.OSUsed > peak[i])
+      peak[i] = data.OSUsed;
+}
+
+/* Size to configure for 'row': peak + margin + ISR reserve */
+static INT32U stack_size(int row)
+{
+  INT32U words = (peak[row] + sizeof(OS_STK) - 1) / sizeof(OS_STK);
+
+  if (peak[row] == 0)
+    return rows[row].size; /* never measured */
+  words = words * (100 + STACK_MARGIN) / 100 + STACK_ISR_RESERVE;
+  return (words + STACK_ROUND - 1) / STACK_ROUND * STACK_ROUND;
+}
+
+/*
+ * Prints size, peak and canary state of every stack, then the lines of
+ * stack_sizes.h for the measured peaks.
+ */
+void stacks_report(void)
+{
+  INT32U total = 0, sized = 0;
+  int i;
+
+  stacks_sample();
+  stacks_check();
+  printf("%-12s %4s %8s %8s %8s\n", "stack", "prio", "size", "peak", "canary");
+  for (i = 0; i < STACK_ROWS; ++i) {
+    printf("%-12s %4d %8lu %8lu %8s\n", rows[i].name, rows[i].prio,
+           (unsigned long) (rows[i].size * sizeof(OS_STK)), (unsigned long) peak[i],
+           overflowed[i] ? "BROKEN" : "ok");
+    total += rows[i].size;
+    sized += stack_size(i);
+  }
+  printf("%lu bytes of stack, %lu with the sizes below (margin %d %%, ISR reserve %d)\n",
+         (unsigned long) (total * sizeof(OS_STK)), (unsigned long) (sized * sizeof(OS_STK)),
+         STACK_MARGIN, STACK_ISR_RESERVE);
+  for (i = 0; i < STACK_ROWS; ++i)
+    printf("#define STACK_%-9s %lu\n", rows[i].id, (unsigned long) stack_size(i));
+}
@@ -0,0 +1,39 @@
+#ifndef STACKS_H_
+#define STACKS_H_
+
+#include "includes.h"
+
+/*
+ * Stack sizing and overflow detection for the task table.
+ *
+ * Every task stack (and the one of StartTask) has STACK_CANARY_WORDS
+ * extra entries below the bottom that uC/OS-II is given. stacks_init()
+ * fills them with STACK_CANARY, and stacks_check() reports a task whose
+ * canary was overwritten, i.e. whose stack overflowed.
+ *
+ * The stacks start zeroed, so OSTaskStkChk() returns the high-water mark
+ * of each task since its creation. stacks_report() prints it for every
+ * task together with the size to configure in stack_sizes.h: the peak
+ * plus STACK_MARGIN % plus STACK_ISR_RESERVE entries, rounded up to 8
+ * entries. The reserve is there because the HAL runs the interrupt
+ * handlers on the stack of the interrupted task, so a peak measured
+ * without an interrupt at the deepest point is not the worst case.
+ * StartTask deletes itself, so it samples its own stack before.
+ */
+
+#define STACK_CANARY_WORDS 4
+#define STACK_CANARY       0xa5c3e1f7
+
+#ifndef STACK_MARGIN
+#define STACK_MARGIN       25  /* % */
+#endif
+#define STACK_ISR_RESERVE  128 /* OS_STK entries */
+
+extern OS_STK StartTask_Stack[];
+
+void stacks_init(void);
+int  stacks_check(void);
+void stacks_sample(void);
+void stacks_report(void);
+
+#endif /*STACKS_H_*/
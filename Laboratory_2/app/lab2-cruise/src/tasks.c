@@ -0,0 +1,432 @@
+/*
+ * Task table and periodic release.
+ *
+ * Each task receives its own task_t as 'pdata' and blocks in
+ * wait_for_release(pdata) until its next release.
+ *
+ * The cost of the release path is measured with the timestamp timer for
+ * every tick that releases at least one task and reported by
+ * release_report(). For the dispatcher this is the time spent in the
+ * alarm callback; for RELEASE_OS_TMR it is the time from OSTmrSignal()
+ * until the timer task has run the last callback of the tick, which
+ * includes the switch to and from the timer task.
+ */
+#include <stdio.h>
+#include "sys/alt_alarm.h"
+#include "tasks.h"
+#include "stacks.h"
+#include "timestamp.h"
+#include "logger.h"
+#include "shed.h"
+
+#define CRUISE_TASK_DECLARE(id, entry, period, phase, prio, stack, wcet, release, crit) \
+  void entry(void* pdata);                                                          \
+  OS_STK entry##_Stack[STACK_CANARY_WORDS + (stack)];
+CRUISE_TASKS(CRUISE_TASK_DECLARE)
+#undef CRUISE_TASK_DECLARE
+
+/* upper case parameters: the lower case ones would replace the designators */
+#define CRUISE_TASK_ROW(ID, ENTRY, PERIOD, PHASE, PRIO, STACK, WCET, RELEASE, CRIT) \
+  { .name = #ENTRY, .entry = ENTRY, .period = PERIOD, .phase = PHASE, .prio = PRIO,  \
+    .stack = &ENTRY##_Stack[STACK_CANARY_WORDS], .stack_size = STACK, .wcet = WCET,  \
+    .release = RELEASE, .crit = CRIT },
+task_t tasks[CRUISE_NUM_TASKS] = {
+  CRUISE_TASKS(CRUISE_TASK_ROW)
+};
+#undef CRUISE_TASK_ROW
+
+/* every task needs its own release bit */
+CRUISE_STATIC_ASSERT(release_flag_bits, CRUISE_NUM_TASKS <= 8 * sizeof(OS_FLAGS));
+
+static OS_FLAG_GRP* release_flags;
+static OS_FLAG_GRP* run_flags; /* cleared for the tasks held by tasks_shed() */
+static alt_alarm release_alarm;
+static alt_u32 release_ticks; /* alarm period in system clock ticks */
+
+typedef struct {
+  INT32U count;
+  INT32U max;
+  INT32U total;
+} release_cost_t;
+
+static release_cost_t release_cost; /* ticks that released tasks */
+static release_cost_t empty_cost;   /* ticks that released nothing */
+
+static void release_account(release_cost_t* c, INT32U cost)
+{
+  c->count++;
+  c->total += cost;
+  if (cost > c->max)
+    c->max = cost;
+}
+
+#if RELEASE_OS_TMR
+
+static volatile INT32U signal_stamp; /* time of the last OSTmrSignal() */
+static volatile INT32U tick_cost;    /* cost of the current tick so far */
+
+static void release_callback(void* ptmr, void* parg)
+{
+  task_t* t = (task_t*) parg;
+  INT8U err;
+
+  rtstats_release(&t->stats, signal_stamp);
+  OSFlagPost(release_flags, t->release_flag, OS_FLAG_SET, &err);
+  tick_cost = timestamp_now() - signal_stamp;
+}
+
+static alt_u32 release_tick(void* context)
+{
+  if (tick_cost) {
+    release_account(&release_cost, tick_cost);
+    tick_cost = 0;
+  }
+  signal_stamp = timestamp_now();
+  OSTmrSignal(); /* Signals a 'tick' to the SW timers */
+
+  return release_ticks;
+}
+
+static void release_table_init(void)
+{
+  INT8U err;
+  int i;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    task_t* t = &tasks[i];
+
+    if (t->release != RELEASE_TIMER)
+      continue;
+    t->timer = OSTmrCreate(t->phase * OS_TMR_CFG_TICKS_PER_SEC / 1000,
+                           t->period * OS_TMR_CFG_TICKS_PER_SEC / 1000,
+                           OS_TMR_OPT_PERIODIC,
+                           release_callback,
+                           t,
+                           (INT8U*) t->name,
+                           &err);
+    if (err != OS_NO_ERR)
+      printf("Timer of %s not created (%d)!\n", t->name, err);
+    else
+      OSTmrStart(t->timer, &err);
+  }
+}
+
+#else /* release dispatcher */
+
+/*
+ * Release table: the ticks of one hyperperiod at which at least one task
+ * is released, in increasing order, with the release bits of that tick.
+ * The dispatcher only compares the tick counter with the next entry.
+ */
+typedef struct {
+  INT16U   tick;
+  OS_FLAGS mask;
+} release_entry_t;
+
+static release_entry_t releases[RELEASE_TABLE_SIZE];
+static int    nreleases;
+static int    next_release;
+static INT16U hyperperiod; /* ticks */
+static INT16U now;         /* tick within the hyperperiod */
+
+static alt_u32 release_tick(void* context)
+{
+  INT32U start = timestamp_now();
+  OS_FLAGS mask;
+  INT8U err;
+  int i;
+
+  if (nreleases && now == releases[next_release].tick) {
+    mask = releases[next_release].mask;
+    for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+      if (mask & tasks[i].release_flag)
+        rtstats_release(&tasks[i].stats, start);
+    OSFlagPost(release_flags, mask, OS_FLAG_SET, &err);
+    if (++next_release == nreleases)
+      next_release = 0;
+    release_account(&release_cost, timestamp_now() - start);
+  } else {
+    release_account(&empty_cost, timestamp_now() - start);
+  }
+  if (++now == hyperperiod)
+    now = 0;
+
+  return release_ticks;
+}
+
+static INT32U gcd(INT32U a, INT32U b)
+{
+  while (b) {
+    INT32U r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+static void release_table_init(void)
+{
+  INT32U h = 1;
+  INT32U t;
+  OS_FLAGS mask;
+  int i;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+    if (tasks[i].release == RELEASE_TIMER)
+      h = h / gcd(h, tasks[i].period / HW_TIMER_PERIOD) * (tasks[i].period / HW_TIMER_PERIOD);
+  if (h > 0xffff) {
+    printf("Hyperperiod of %lu ticks too long, no releases!\n", (unsigned long) h);
+    return;
+  }
+  hyperperiod = (INT16U) h;
+
+  for (t = 0; t < h; ++t) {
+    mask = 0;
+    for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+      if (tasks[i].release == RELEASE_TIMER &&
+          t % (tasks[i].period / HW_TIMER_PERIOD) == tasks[i].phase / HW_TIMER_PERIOD)
+        mask |= tasks[i].release_flag;
+    if (!mask)
+      continue;
+    if (nreleases == RELEASE_TABLE_SIZE) {
+      printf("Release table full at tick %lu!\n", (unsigned long) t);
+      return;
+    }
+    releases[nreleases].tick = (INT16U) t;
+    releases[nreleases].mask = mask;
+    nreleases++;
+  }
+  printf("Release table: %d entries in a hyperperiod of %u ms\n",
+         nreleases, (unsigned) (hyperperiod * HW_TIMER_PERIOD));
+}
+
+#endif /* RELEASE_OS_TMR */
+
+/*
+ * Creates the release flag group and the release table (or the timers).
+ * Called before the OS is started.
+ */
+void tasks_create_releases(void)
+{
+  INT8U err;
+  int i;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    rtstats_init(&tasks[i].stats);
+    if (tasks[i].release == RELEASE_TIMER)
+      tasks[i].release_flag = (OS_FLAGS) 1 << i;
+  }
+
+  release_flags = OSFlagCreate(0, &err);
+  if (err != OS_NO_ERR)
+    printf("Release flags not created (%d)!\n", err);
+  run_flags = OSFlagCreate((OS_FLAGS) ~0, &err);
+  if (err != OS_NO_ERR)
+    printf("Run flags not created (%d)!\n", err);
+
+  release_table_init();
+}
+
+/*
+ * Starts the alarm that drives the releases, every HW_TIMER_PERIOD ms.
+ */
+void tasks_start_releases(void)
+{
+  release_ticks = alt_ticks_per_second() * HW_TIMER_PERIOD / 1000;
+  if (release_ticks == 0)
+    release_ticks = 1;
+  printf("delay in ticks %lu\n", (unsigned long) release_ticks);
+
+  if (alt_alarm_start(&release_alarm, release_ticks, release_tick, NULL) < 0)
+    printf("No system clock available!\n");
+}
+
+void tasks_create(void)
+{
+  INT8U err;
+  int i;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    task_t* t = &tasks[i];
+
+    err = OSTaskCreateExt(
+        t->entry,                   // Pointer to task code
+        t,                          // Its table row as argument
+        &t->stack[t->stack_size-1], // Pointer to top of task stack
+        t->prio,
+        t->prio,
+        &t->stack[0],
+        t->stack_size,
+        (void *) 0,
+        OS_TASK_OPT_STK_CHK);
+    if (err != OS_NO_ERR)
+      printf("%s not created (%d)!\n", t->name, err);
+  }
+}
+
+/*
+ * Completes the current job of the calling task and blocks until its
+ * next release. A task held by tasks_shed() stops here, at a job
+ * boundary, so it never stops while it holds a lock (e.g. stdout); the
+ * releases it missed meanwhile are skipped.
+ */
+void wait_for_release(void* pdata)
+{
+  task_t* t = (task_t*) pdata;
+  INT8U err;
+
+  rtstats_complete(&t->stats, timestamp_now());
+  if (t->shed) {
+    OSFlagPend(run_flags, t->release_flag, OS_FLAG_WAIT_SET_ALL, 0, &err);
+    OSFlagAccept(release_flags, t->release_flag,
+                 OS_FLAG_WAIT_SET_ALL + OS_FLAG_CONSUME, &err);
+  }
+  OSFlagPend(release_flags, t->release_flag,
+             OS_FLAG_WAIT_SET_ALL + OS_FLAG_CONSUME, 0, &err);
+  rtstats_start(&t->stats, timestamp_now());
+}
+
+/*
+ * Completes the current job of the calling task and blocks until all
+ * 'flags' of 'grp' are set, then until the next release after that.
+ * Releases that come while the task waits for the flags are skipped.
+ */
+void wait_for_flags(void* pdata, OS_FLAG_GRP* grp, OS_FLAGS flags)
+{
+  task_t* t = (task_t*) pdata;
+  INT8U err;
+
+  rtstats_complete(&t->stats, timestamp_now());
+  t->parked = 1;
+  OSFlagPend(grp, flags, OS_FLAG_WAIT_SET_ALL, 0, &err);
+  OSFlagAccept(release_flags, t->release_flag,
+               OS_FLAG_WAIT_SET_ALL + OS_FLAG_CONSUME, &err);
+  t->parked = 0;
+  OSFlagPend(release_flags, t->release_flag,
+             OS_FLAG_WAIT_SET_ALL + OS_FLAG_CONSUME, 0, &err);
+  rtstats_start(&t->stats, timestamp_now());
+}
+
+void task_job_start(void* pdata, INT32U release)
+{
+  task_t* t = (task_t*) pdata;
+
+  rtstats_release(&t->stats, release);
+  rtstats_start(&t->stats, timestamp_now());
+}
+
+void task_job_complete(void* pdata)
+{
+  rtstats_complete(&((task_t*) pdata)->stats, timestamp_now());
+}
+
+/*
+ * Prints the jitter and response time statistics of all tasks. Each
+ * task's statistics are copied in a critical section first, so the
+ * report of a task is consistent even if it runs meanwhile.
+ */
+void tasks_report(void)
+{
+  static rt_stats_t copy;
+  int i;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  printf("Release jitter and response times:\n");
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    OS_ENTER_CRITICAL();
+    copy = tasks[i].stats;
+    OS_EXIT_CRITICAL();
+    rtstats_print(tasks[i].name, &copy);
+  }
+}
+
+/*
+ * Returns the number of CRIT_HIGH timer-released tasks whose current job
+ * is released but not yet started with less than 'margin_ms' of its
+ * period left, i.e. jobs that are about to miss their deadline. Tasks
+ * parked in wait_for_flags() skip their releases and are not counted.
+ */
+int tasks_at_risk(INT32U margin_ms)
+{
+  INT32U now = timestamp_now();
+  INT32U waited, limit;
+  int i, n = 0;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  if (timestamp_freq() == 0)
+    return 0;
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    task_t* t = &tasks[i];
+
+    if (t->crit != CRIT_HIGH || t->release != RELEASE_TIMER || t->period <= margin_ms)
+      continue;
+    limit = (INT32U) ((alt_u64) (t->period - margin_ms) * timestamp_freq() / 1000);
+    OS_ENTER_CRITICAL();
+    waited = t->stats.waiting && !t->parked ? now - t->stats.release : 0;
+    OS_EXIT_CRITICAL();
+    if (waited >= limit)
+      ++n;
+  }
+  return n;
+}
+
+/*
+ * Applies the load shedding 'level' (shed.h) to the timer-released tasks:
+ * tasks that give up their CPU at this level stop in wait_for_release()
+ * at the end of their current job, tasks that no longer do are let go.
+ * Called by Monitor only.
+ */
+void tasks_shed(int level)
+{
+  OS_FLAGS hold = 0, run = 0;
+  INT8U err;
+  int i;
+
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i) {
+    if (tasks[i].release != RELEASE_TIMER)
+      continue;
+    if (shed_suspends(level, tasks[i].crit))
+      hold |= tasks[i].release_flag;
+    else
+      run |= tasks[i].release_flag;
+  }
+
+  /* clear the bits before the tasks see 'shed' set */
+  OSFlagPost(run_flags, hold, OS_FLAG_CLR, &err);
+  OSFlagPost(run_flags, run, OS_FLAG_SET, &err);
+  for (i = 0; i < CRUISE_NUM_TASKS; ++i)
+    tasks[i].shed = (hold & tasks[i].release_flag) != 0;
+}
+
+static INT32U to_ns(INT32U stamps)
+{
+  return (INT32U) ((alt_u64) stamps * 1000000000u / timestamp_freq());
+}
+
+/*
+ * Logs the mean and maximum release cost per tick since the previous
+ * report and starts a new measurement.
+ */
+void release_report(void)
+{
+  release_cost_t rel, empty;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr;
+#endif
+
+  OS_ENTER_CRITICAL();
+  rel = release_cost;
+  empty = empty_cost;
+  release_cost.count = release_cost.max = release_cost.total = 0;
+  empty_cost.count = empty_cost.max = empty_cost.total = 0;
+  OS_EXIT_CRITICAL();
+
+  if (rel.count == 0 || timestamp_freq() == 0)
+    return;
+  LOG(LOG_RELEASE_OVERHEAD, to_ns(rel.total / rel.count), to_ns(rel.max),
+      empty.count ? to_ns(empty.total / empty.count) : 0, RELEASE_OS_TMR);
+}
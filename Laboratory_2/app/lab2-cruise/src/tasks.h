@@ -0,0 +1,65 @@
+#ifndef TASKS_H_
+#define TASKS_H_
+
+#include "includes.h"
+#include "cruise_tasks.h"
+#include "rtstats.h"
+
+/*
+ * Run-time view of the task table in cruise_tasks.h and the release of
+ * the RELEASE_TIMER tasks.
+ *
+ * Every timer-released task owns one bit of a single event flag group
+ * and waits for it in wait_for_release(). By default the bits are set by
+ * a dispatcher that runs from the 1 ms system clock alarm and walks a
+ * release table precomputed over the hyperperiod, so all tasks due in a
+ * tick are made ready by a single OSFlagPost(). With RELEASE_OS_TMR set,
+ * one periodic OS timer per task sets the bit instead, which is kept to
+ * compare the release overhead of both paths.
+ *
+ * While load is shed (shed.h), tasks_shed() clears the bit of every
+ * task that gives up its CPU in a second flag group, and such a task
+ * waits for it at its next job boundary in wait_for_release().
+ *
+ * The release jitter and response time of every job are recorded in the
+ * task's rt_stats_t. Timer-released tasks are stamped by the release
+ * path and wait_for_release(). RELEASE_EVENT tasks call task_job_start()
+ * with the time stamp of their event and task_job_complete() before
+ * they wait for the next one.
+ */
+
+#define RELEASE_TABLE_SIZE 32 /* release instants per hyperperiod */
+
+typedef struct {
+  const char* name;
+  void      (*entry)(void* pdata);
+  INT16U      period;       /* ms */
+  INT16U      phase;        /* ms */
+  INT8U       prio;
+  OS_STK*     stack;        /* bottom, above the canary (stacks.h) */
+  INT32U      stack_size;
+  INT32U      wcet;         /* us */
+  INT8U       release;
+  INT8U       crit;         /* CRIT_* of cruise_tasks.h */
+  INT8U       shed;         /* held by tasks_shed() */
+  INT8U       parked;       /* in wait_for_flags(), releases are skipped */
+  OS_FLAGS    release_flag; /* bit in the release flag group */
+  OS_TMR*     timer;        /* RELEASE_OS_TMR only */
+  rt_stats_t  stats;
+} task_t;
+
+extern task_t tasks[CRUISE_NUM_TASKS];
+
+void tasks_create_releases(void);
+void tasks_start_releases(void);
+void tasks_create(void);
+void wait_for_release(void* pdata);
+void wait_for_flags(void* pdata, OS_FLAG_GRP* grp, OS_FLAGS flags);
+void task_job_start(void* pdata, INT32U release);
+void task_job_complete(void* pdata);
+void tasks_report(void);
+int  tasks_at_risk(INT32U margin_ms);
+void tasks_shed(int level);
+void release_report(void);
+
+#endif /*TASKS_H_*/
@@ -0,0 +1,128 @@
+/*
+ * Telemetry frames (see telemetry.h).
+ *
+ * The producer (VehicleTask) fills a private frame and, when it is
+ * complete, copies it into a single-producer single-consumer ring of
+ * TELEM_FRAMES frames. The consumer (LogTask) owns 'tail', the producer
+ * everything else, so neither needs a lock.
+ */
+#include <string.h>
+#include "telemetry.h"
+#include "vehicle_model.h"
+
+#define barrier() __sync_synchronize()
+
+#define TELEM_MASK (TELEM_FRAMES - 1)
+
+typedef char telem_ring_check[(TELEM_FRAMES & TELEM_MASK) == 0 ? 1 : -1];
+
+static uint8_t building[TELEM_FRAME_SIZE];
+static int count = 0;        /* samples in 'building' */
+static uint16_t seq = 0;
+static uint16_t sample_period = 0;
+static volatile int16_t target_velocity = 0;
+
+static uint8_t ring[TELEM_FRAMES][TELEM_FRAME_SIZE];
+static volatile uint32_t head = 0; /* frames queued */
+static volatile uint32_t tail = 0; /* frames taken */
+static uint32_t dropped = 0;
+
+/* CRC-16/CCITT, four bits at a time */
+static const uint16_t crc_nibble[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+  0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+uint16_t telem_crc(const uint8_t* p, int n)
+{
+  uint16_t crc = 0xffff;
+
+  while (n--) {
+    crc = (uint16_t) (crc << 4) ^ crc_nibble[(crc >> 12) ^ (*p >> 4)];
+    crc = (uint16_t) (crc << 4) ^ crc_nibble[(crc >> 12) ^ (*p & 0x0f)];
+    ++p;
+  }
+  return crc;
+}
+
+static void put16(uint8_t* p, uint32_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+}
+
+static void put32(uint8_t* p, uint32_t v)
+{
+  put16(p, v);
+  put16(p + 2, v >> 16);
+}
+
+void telem_init(uint16_t period)
+{
+  count = 0;
+  seq = 0;
+  sample_period = period;
+  target_velocity = 0;
+  head = tail = 0;
+  dropped = 0;
+}
+
+void telem_target(int16_t target)
+{
+  target_velocity = target;
+}
+
+/*
+ * position and velocity in Q16.16 as in vehicle_t, mode as MODE_* bits
+ */
+void telem_sample(uint32_t tick, int32_t position, int32_t velocity,
+                  uint8_t throttle, uint8_t mode)
+{
+  uint8_t* s = &building[TELEM_HEADER_SIZE + count * TELEM_SAMPLE_SIZE];
+
+  if (count == 0) {
+    put16(building, TELEM_SYNC);
+    put16(building + 2, seq);
+    put32(building + 4, tick);
+    put16(building + 8, sample_period);
+  }
+  put16(s, (uint32_t) VEHICLE_INT(position));
+  put16(s + 2, (uint32_t) (velocity >> 8));
+  put16(s + 4, (throttle & TELEM_THROTTLE_MASK) | (uint32_t) mode << TELEM_MODE_SHIFT);
+  if (++count < TELEM_SAMPLES)
+    return;
+
+  put16(building + 10, (uint32_t) target_velocity);
+  put16(building + TELEM_FRAME_SIZE - 2, telem_crc(building + 2, TELEM_FRAME_SIZE - 4));
+  if (head - tail < TELEM_FRAMES) {
+    memcpy(ring[head & TELEM_MASK], building, TELEM_FRAME_SIZE);
+    barrier();
+    head = head + 1;
+  } else {
+    ++dropped;
+  }
+  ++seq;
+  count = 0;
+}
+
+/*
+ * Copies the oldest queued frame to 'frame' and returns its size, or 0
+ * if no frame is queued.
+ */
+int telem_take(uint8_t* frame)
+{
+  uint32_t t = tail;
+
+  if (t == head)
+    return 0;
+  barrier();
+  memcpy(frame, ring[t & TELEM_MASK], TELEM_FRAME_SIZE);
+  barrier();
+  tail = t + 1;
+  return TELEM_FRAME_SIZE;
+}
+
+uint32_t telem_dropped(void)
+{
+  return dropped;
+}
@@ -0,0 +1,62 @@
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+
+/*
+ * Binary telemetry of the vehicle and controller state.
+ *
+ * VehicleTask adds one sample per step with telem_sample(). Samples are
+ * packed into fixed-size frames of TELEM_SAMPLES; a completed frame is
+ * queued for LogTask, which writes it to the JTAG UART with telem_take().
+ * If LogTask falls behind by TELEM_FRAMES frames, completed frames are
+ * dropped and counted, never the producer delayed. host/telemdecode
+ * turns the stream into CSV.
+ *
+ * Frame (little endian, TELEM_FRAME_SIZE bytes):
+ *
+ *   0  sync      u16  TELEM_SYNC
+ *   2  seq       u16  frame number, a gap is a dropped frame
+ *   4  tick      u32  OS tick of the first sample
+ *   8  period    u16  ticks between samples
+ *  10  target    s16  target velocity (m/s) when the frame was completed
+ *  12  samples        TELEM_SAMPLES x 6 bytes:
+ *                       position u16 (m), velocity s16 (m/s, Q8.8),
+ *                       throttle (bits 0-6) | mode (bits 7-11) u16
+ *   n  crc       u16  CRC-16/CCITT (0x1021, init 0xffff) of bytes 2..n-1
+ *
+ * A sample costs 6.9 bytes of the stream, against ~73 bytes of a text
+ * "Position: ..." line of the log, so the UART has room for 10.6 times
+ * as many samples. That room is capacity only: the vehicle state changes
+ * once per VEHICLE_PERIOD, and one sample is taken per step, the rate of
+ * the text line. The stream does not deliver more samples per second,
+ * it takes about a tenth of the UART time for the same ones. The
+ * acceleration is not sent; host/telemdecode derives it from the
+ * velocities. The sync word differs from the LOG_SYNC of
+ * logger.h and frames are checked by their CRC, so text and log records
+ * may share the UART.
+ */
+
+#ifndef TELEMETRY
+#define TELEMETRY 0
+#endif
+
+#define TELEM_SYNC        0x4d54 /* "TM" */
+#define TELEM_SAMPLES     16
+#define TELEM_FRAMES      4      /* queued frames, power of two */
+#define TELEM_HEADER_SIZE 12
+#define TELEM_SAMPLE_SIZE 6
+#define TELEM_FRAME_SIZE  (TELEM_HEADER_SIZE + TELEM_SAMPLES * TELEM_SAMPLE_SIZE + 2)
+
+#define TELEM_THROTTLE_MASK 0x7f
+#define TELEM_MODE_SHIFT    7
+
+void     telem_init(uint16_t period);
+void     telem_target(int16_t target);
+void     telem_sample(uint32_t tick, int32_t position, int32_t velocity,
+                      uint8_t throttle, uint8_t mode);
+int      telem_take(uint8_t* frame);
+uint32_t telem_dropped(void);
+uint16_t telem_crc(const uint8_t* p, int n);
+
+#endif /*TELEMETRY_H_*/
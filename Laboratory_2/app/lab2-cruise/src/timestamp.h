@@ -0,0 +1,59 @@
+#ifndef TIMESTAMP_H_
+#define TIMESTAMP_H_
+
+#include <stdint.h>
+
+/*
+ * Free-running high-resolution time stamps.
+ *
+ * On the board these come from the HAL timestamp timer (timer_1, clocked
+ * at the CPU frequency). A host build uses CLOCK_MONOTONIC in ns. Values
+ * are 32 bits wide and wrap, so only differences taken with unsigned
+ * arithmetic are meaningful, and only for intervals shorter than the
+ * wrap: ~85 s at 50 MHz on the board, but ~4.29 s in ns on the host.
+ */
+
+#ifdef __nios2__
+
+#include "sys/alt_timestamp.h"
+
+static inline int timestamp_start(void)
+{
+  return alt_timestamp_start();
+}
+
+static inline uint32_t timestamp_now(void)
+{
+  return (uint32_t) alt_timestamp();
+}
+
+static inline uint32_t timestamp_freq(void)
+{
+  return (uint32_t) alt_timestamp_freq();
+}
+
+#else /* host */
+
+#include <time.h>
+
+static inline int timestamp_start(void)
+{
+  return 0;
+}
+
+static inline uint32_t timestamp_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+
+static inline uint32_t timestamp_freq(void)
+{
+  return 1000000000u;
+}
+
+#endif
+
+#endif /*TIMESTAMP_H_*/
@@ -0,0 +1,97 @@
+/*
+ * Track description and position lookup.
+ *
+ * track_init() expands the segment table into 'track_index', which maps
+ * every TRACK_GRID metre cell of the track to its segment. Lookups then
+ * cost one shift and two loads, independent of the segment count.
+ */
+#include <stdio.h>
+#include "track.h"
+
+#define GRAVITY_FACTOR 2
+
+/*
+ * LEDR17: [0m, 400m)     flat
+ * LEDR16: [400m, 800m)   uphill
+ * LEDR15: [800m, 1200m)  steep uphill
+ * LEDR14: [1200m, 1600m) flat
+ * LEDR13: [1600m, 2000m) downhill
+ * LEDR12: [2000m, 2400m] steep downhill
+ */
+#define TRACK_TABLE(X)                 \
+  X(    0,  0,                17)      \
+  X(  400, -GRAVITY_FACTOR,   16)      \
+  X(  800, -2*GRAVITY_FACTOR, 15)      \
+  X( 1200,  0,                14)      \
+  X( 1600,  2*GRAVITY_FACTOR, 13)      \
+  X( 2000,  GRAVITY_FACTOR,   12)
+
+#define TRACK_ROW(start, gradient, led) { start, gradient, led },
+static const track_segment_t track[] = {
+  TRACK_TABLE(TRACK_ROW)
+};
+#undef TRACK_ROW
+
+#define TRACK_SEGMENTS (sizeof(track) / sizeof(track[0]))
+#define TRACK_CELLS    ((TRACK_LENGTH >> TRACK_GRID_SHIFT) + 1)
+
+/* every segment must start on the grid and on the track, and the index
+   must fit in a byte; the order of the rows is checked by track_init() */
+#define TRACK_ON_GRID(start, gradient, led) \
+  && (start) % TRACK_GRID == 0 && (start) <= TRACK_LENGTH
+typedef char track_grid_check[(TRACK_LENGTH % TRACK_GRID == 0 TRACK_TABLE(TRACK_ON_GRID)) ? 1 : -1];
+typedef char track_size_check[(TRACK_SEGMENTS <= 256) ? 1 : -1];
+
+static uint8_t track_index[TRACK_CELLS];
+static int track_ready = 0;
+
+void track_init(void)
+{
+  unsigned int cell, seg;
+
+  if (track_ready)
+    return;
+
+  if (track[0].start != 0)
+    printf("Track starts at %u m, not 0 m!\n", track[0].start);
+  for (seg = 1; seg < TRACK_SEGMENTS; ++seg)
+    if (track[seg].start <= track[seg - 1].start)
+      printf("Track segment %u starts at %u m, not after %u m!\n", seg,
+             track[seg].start, track[seg - 1].start);
+
+  seg = 0;
+  for (cell = 0; cell < TRACK_CELLS; ++cell) {
+    while (seg + 1 < TRACK_SEGMENTS &&
+           (cell << TRACK_GRID_SHIFT) >= track[seg + 1].start)
+      ++seg;
+    track_index[cell] = (uint8_t) seg;
+  }
+  track_ready = 1;
+}
+
+static const track_segment_t* segment(int32_t position)
+{
+  if (position < 0 || position > TRACK_LENGTH)
+    return 0;
+  return &track[track_index[position >> TRACK_GRID_SHIFT]];
+}
+
+/*
+ * Gravity effect at 'position' (whole metres) in m/s2
+ */
+int32_t track_gradient(int32_t position)
+{
+  const track_segment_t* s = segment(position);
+
+  return s ? s->gradient : 0;
+}
+
+/*
+ * Red LED mask of the segment containing 'position', 0 off the track
+ */
+uint32_t track_led_mask(int32_t position)
+{
+  const track_segment_t* s = segment(position);
+
+  return s ? (uint32_t) 1 << s->led : 0;
+}
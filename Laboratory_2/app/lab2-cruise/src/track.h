@@ -0,0 +1,29 @@
+#ifndef TRACK_H_
+#define TRACK_H_
+
+#include <stdint.h>
+
+/*
+ * Track profile of the cruise control lab.
+ *
+ * The track is described once, in track.c, as a table of segments with
+ * their start position, gradient and position LED. Segment boundaries
+ * lie on a TRACK_GRID metre grid, so the segment of any position is
+ * found with a single index lookup no matter how many segments there are.
+ */
+
+#define TRACK_LENGTH     2400 /* m, last valid position */
+#define TRACK_GRID_SHIFT 4
+#define TRACK_GRID       (1 << TRACK_GRID_SHIFT) /* m */
+
+typedef struct {
+  uint16_t start;    /* m, multiple of TRACK_GRID */
+  int8_t   gradient; /* gravity effect in m/s2, < 0 uphill */
+  uint8_t  led;      /* red LED showing the segment */
+} track_segment_t;
+
+void     track_init(void);
+int32_t  track_gradient(int32_t position);
+uint32_t track_led_mask(int32_t position);
+
+#endif /*TRACK_H_*/
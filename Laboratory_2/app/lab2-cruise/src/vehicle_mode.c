@@ -0,0 +1,65 @@
+/*
+ * Vehicle mode table (see vehicle_mode.h).
+ */
+#include "vehicle_mode.h"
+
+typedef struct {
+  uint8_t event;
+  uint8_t mask;
+  uint8_t match;
+  uint8_t guard;
+  uint8_t clear;
+  uint8_t set;
+} mode_rule_t;
+
+static const mode_rule_t rules[] = {
+#define MODE_RULE(event, mask, match, guard, clear, set) \
+  { event, mask, match, guard, clear, set },
+#include "vehicle_mode_rules.h"
+#undef MODE_RULE
+};
+
+#define MODE_NUM_RULES (sizeof(rules) / sizeof(rules[0]))
+
+static const char* const event_names[MODE_NUM_EVENTS] = {
+#define MODE_EVENT(id, name) name,
+#include "vehicle_mode_rules.h"
+#undef MODE_EVENT
+};
+
+uint8_t mode_table[MODE_NUM_EVENTS][MODE_CONDS][MODE_STATES];
+
+void mode_init(void)
+{
+  const mode_rule_t* r;
+  int e, c, s;
+  unsigned int i;
+
+  for (e = 0; e < MODE_NUM_EVENTS; ++e)
+    for (c = 0; c < MODE_CONDS; ++c)
+      for (s = 0; s < MODE_STATES; ++s) {
+        mode_table[e][c][s] = (uint8_t) s;
+        for (i = 0; i < MODE_NUM_RULES; ++i) {
+          r = &rules[i];
+          if (r->event == e && (s & r->mask) == r->match && (c & r->guard) == r->guard) {
+            mode_table[e][c][s] = (uint8_t) ((s & ~r->clear) | r->set);
+            break;
+          }
+        }
+      }
+}
+
+const char* mode_event_name(int event)
+{
+  return event >= 0 && event < MODE_NUM_EVENTS ? event_names[event] : "?";
+}
+
+void mode_format(uint8_t state, char* buf)
+{
+  static const char letters[MODE_BITS] = { 'E', 'T', 'G', 'B', 'C' };
+  int i;
+
+  for (i = 0; i < MODE_BITS; ++i)
+    buf[i] = (state & (1 << i)) ? letters[i] : '-';
+  buf[MODE_BITS] = '\0';
+}
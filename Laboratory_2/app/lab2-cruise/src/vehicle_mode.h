@@ -0,0 +1,61 @@
+#ifndef VEHICLE_MODE_H_
+#define VEHICLE_MODE_H_
+
+#include <stdint.h>
+
+/*
+ * Mode state machine of the vehicle controls.
+ *
+ * The mode is a set of bits (engine, top gear, pedals, cruise control)
+ * that only changes on the events of vehicle_mode_rules.h, guarded by
+ * conditions on the vehicle state. mode_init() compiles the rules into
+ * a table indexed by event, conditions and state, so a transition is a
+ * single lookup whatever the number of rules.
+ *
+ * The mode bits are also the flags of the OSFlag group through which the
+ * application publishes the mode, so tasks can pend on a mode directly.
+ * This module only uses <stdint.h>, so host tools can replay events
+ * against the same table.
+ */
+
+#define MODE_ENGINE   0x01
+#define MODE_TOP_GEAR 0x02
+#define MODE_GAS      0x04
+#define MODE_BRAKE    0x08
+#define MODE_CRUISE   0x10
+#define MODE_BITS     5
+#define MODE_STATES   (1 << MODE_BITS)
+
+/* guard conditions, from the vehicle velocity by mode_cond() */
+#define MODE_COND_STOPPED      0x01 /* velocity 0 */
+#define MODE_COND_CRUISE_SPEED 0x02 /* velocity of at least 20 m/s */
+#define MODE_CONDS             4
+
+#define MODE_CRUISE_MIN_VELOCITY 20 /* m/s */
+
+enum mode_event {
+#define MODE_EVENT(id, name) id,
+#include "vehicle_mode_rules.h"
+#undef MODE_EVENT
+  MODE_NUM_EVENTS
+};
+
+extern uint8_t mode_table[MODE_NUM_EVENTS][MODE_CONDS][MODE_STATES];
+
+void        mode_init(void);
+const char* mode_event_name(int event);
+void        mode_format(uint8_t state, char* buf); /* 6 chars: "ETGBC" */
+
+/* velocity in whole m/s */
+static inline int mode_cond(int velocity)
+{
+  return (velocity == 0 ? MODE_COND_STOPPED : 0) |
+         (velocity >= MODE_CRUISE_MIN_VELOCITY ? MODE_COND_CRUISE_SPEED : 0);
+}
+
+static inline uint8_t mode_next(uint8_t state, int event, int cond)
+{
+  return mode_table[event][cond][state];
+}
+
+#endif /*VEHICLE_MODE_H_*/
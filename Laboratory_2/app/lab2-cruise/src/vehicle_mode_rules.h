@@ -0,0 +1,40 @@
+/*
+ * Transitions of the vehicle mode (see vehicle_mode.h).
+ *
+ * MODE_EVENT(id, name)
+ *
+ * MODE_RULE(event, mask, match, guard, clear, set)
+ *
+ *   The rule applies to the states s with (s & mask) == match when all
+ *   'guard' conditions hold. It clears the 'clear' bits and sets the
+ *   'set' bits. The first rule of an event that applies wins, an event
+ *   without one leaves the state unchanged.
+ */
+#ifdef MODE_EVENT
+MODE_EVENT(MODE_EV_ENGINE_ON,    "engine on")
+MODE_EVENT(MODE_EV_ENGINE_OFF,   "engine off")
+MODE_EVENT(MODE_EV_TOP_GEAR_ON,  "top gear on")
+MODE_EVENT(MODE_EV_TOP_GEAR_OFF, "top gear off")
+MODE_EVENT(MODE_EV_GAS,          "gas")
+MODE_EVENT(MODE_EV_BRAKE,        "brake")
+MODE_EVENT(MODE_EV_CRUISE,       "cruise")
+#endif
+
+#ifdef MODE_RULE
+/*        event                 mask          match         guard                   clear                        set */
+MODE_RULE(MODE_EV_ENGINE_ON,    0,            0,            0,                      0,                           MODE_ENGINE)
+/* the engine only stops with the vehicle */
+MODE_RULE(MODE_EV_ENGINE_OFF,   0,            0,            MODE_COND_STOPPED,      MODE_ENGINE | MODE_CRUISE,   0)
+MODE_RULE(MODE_EV_TOP_GEAR_ON,  0,            0,            0,                      0,                           MODE_TOP_GEAR)
+/* cruise control is only active in top gear */
+MODE_RULE(MODE_EV_TOP_GEAR_OFF, 0,            0,            0,                      MODE_TOP_GEAR | MODE_CRUISE, 0)
+/* the pedals toggle, pressing one disengages cruise control */
+MODE_RULE(MODE_EV_GAS,          MODE_GAS,     MODE_GAS,     0,                      MODE_GAS,                    0)
+MODE_RULE(MODE_EV_GAS,          0,            0,            0,                      MODE_CRUISE,                 MODE_GAS)
+MODE_RULE(MODE_EV_BRAKE,        MODE_BRAKE,   MODE_BRAKE,   0,                      MODE_BRAKE,                  0)
+MODE_RULE(MODE_EV_BRAKE,        0,            0,            0,                      MODE_CRUISE,                 MODE_BRAKE)
+/* cruise control engages in top gear, above 20 m/s, with no pedal pressed */
+MODE_RULE(MODE_EV_CRUISE,       MODE_CRUISE,  MODE_CRUISE,  0,                      MODE_CRUISE,                 0)
+MODE_RULE(MODE_EV_CRUISE,       MODE_TOP_GEAR | MODE_GAS | MODE_BRAKE,
+                                              MODE_TOP_GEAR, MODE_COND_CRUISE_SPEED, 0,                           MODE_CRUISE)
+#endif
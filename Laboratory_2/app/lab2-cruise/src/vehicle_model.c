@@ -0,0 +1,51 @@
+/*
+ * The car model is equivalent to moving mass with linear resistances acting upon it.
+ * Therefore, if left one, it will stably stop as the velocity converges to zero on a flat surface.
+ *
+ * The state is integrated with forward Euler in Q16.16. Products with
+ * the step length are formed in 64 bits and shifted back, which keeps the
+ * result exact and independent of the compiler and its flags.
+ */
+#include "vehicle_model.h"
+
+// constants that should not be modified
+#define WIND_FACTOR    1
+#define BRAKE_FACTOR   4
+
+void vehicle_init(vehicle_t* v, uint32_t period_ms)
+{
+  v->position = 0;
+  v->velocity = 0;
+  v->acceleration = 0;
+  track_init();
+  v->dt = (int32_t) ((period_ms << VEHICLE_Q) / 1000);
+}
+
+void vehicle_step(vehicle_t* v, uint8_t throttle, int brake, int engine)
+{
+  int32_t acceleration;
+
+  // brakes + wind
+  if (!brake) {
+    // wind resistance
+    acceleration = - WIND_FACTOR*v->velocity;
+    // actuate with engines
+    if (engine)
+      acceleration += VEHICLE_TO_Q16(throttle);
+    // gravity effects
+    acceleration += VEHICLE_TO_Q16(track_gradient(VEHICLE_INT(v->position)));
+  }
+  // if the engine and the brakes are activated at the same time,
+  // we assume that the brake dynamics dominates, so both cases fall
+  // here.
+  else
+    acceleration = - BRAKE_FACTOR*v->velocity;
+
+  v->acceleration = acceleration;
+  v->position += (int32_t) (((int64_t) v->velocity * v->dt) >> VEHICLE_Q);
+  v->velocity += (int32_t) (((int64_t) acceleration * v->dt) >> VEHICLE_Q);
+
+  // reset the position to the beginning of the track
+  if (v->position < 0 || v->position > VEHICLE_TO_Q16(VEHICLE_TRACK_LENGTH))
+    v->position = 0;
+}
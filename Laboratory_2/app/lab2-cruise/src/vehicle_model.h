@@ -0,0 +1,32 @@
+#ifndef VEHICLE_MODEL_H_
+#define VEHICLE_MODEL_H_
+
+#include <stdint.h>
+#include "track.h"
+
+/*
+ * Fixed-point model of the simulated vehicle.
+ *
+ * Position (m), velocity (m/s) and acceleration (m/s2) are kept in
+ * Q16.16. Only integer arithmetic is used, so the same step function
+ * gives bit-identical trajectories on the Nios II target and on a host.
+ */
+
+#define VEHICLE_Q            16
+#define VEHICLE_ONE          ((int32_t) 1 << VEHICLE_Q)
+#define VEHICLE_TO_Q16(x)    ((int32_t) (x) << VEHICLE_Q)
+#define VEHICLE_INT(x)       ((x) >> VEHICLE_Q)
+
+#define VEHICLE_TRACK_LENGTH TRACK_LENGTH /* m */
+
+typedef struct {
+  int32_t position;     /* m, Q16.16 */
+  int32_t velocity;     /* m/s, Q16.16 */
+  int32_t acceleration; /* m/s2, Q16.16 */
+  int32_t dt;           /* step length in s, Q16.16 */
+} vehicle_t;
+
+void vehicle_init(vehicle_t* v, uint32_t period_ms);
+void vehicle_step(vehicle_t* v, uint8_t throttle, int brake, int engine);
+
+#endif /*VEHICLE_MODEL_H_*/
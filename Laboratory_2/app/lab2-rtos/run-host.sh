@@ -0,0 +1,26 @@
+#!/bin/bash
+# @file: run-host.sh
+#
+# Builds one application of this folder against the POSIX host port of
+# uC/OS-II (../posix) and runs it on this machine, with no board
+# attached. Usage: ./run-host.sh Handshake.c
+#
+# Environment: UCOS_RUN_MS=<ms> stops the run after <ms> ms.
+
+POSIX_PATH=../posix
+SRC_PATH=./src
+
+if [ -z "$1" ]; then
+    echo "usage: $0 <application.c>"
+    exit 1
+fi
+APP_NAME=$(basename $1 .c)
+
+mkdir -p bin
+
+gcc -O2 -g -Wall -pthread \
+    -I$POSIX_PATH/include \
+    -o bin/$APP_NAME-host \
+    $SRC_PATH/$APP_NAME.c $POSIX_PATH/*.c || exit 1
+
+./bin/$APP_NAME-host
@@ -0,0 +1,296 @@
+/* Emulated DE2 hardware of the POSIX host port
+ *
+ * Description:
+ *
+ *   System clock: a thread ticks every 1/OS_TICKS_PER_SEC s of wall-clock
+ *   time. Each tick runs OSTimeTick() and the HAL alarms as one interrupt.
+ *   Late ticks are caught up, so OSTimeGet() follows the wall clock.
+ *
+ *   PIOs: every PIO of system.h has the four Avalon PIO registers. The
+ *   keys are active low and capture falling edges. While the edge
+ *   capture bits and the IRQ mask overlap, the registered handler is
+ *   called as an interrupt. Writing the edge capture register clears it.
+ *
+ *   Input: lines on stdin drive the board inputs,
+ *
+ *     k <mask>    press and release the keys in <mask> (KEY0 = 1)
+ *     s <value>   set the toggle switches to <value>
+ *     q           quit
+ *
+ *   and with HAL_TRACE set in the environment every change of an output
+ *   PIO (LEDs, seven-segment displays) is printed to stderr. With
+ *   HAL_COUNT set the reads and writes of every PIO data register are
+ *   counted and printed to stderr when the program stops.
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include "includes.h"
+#include "system.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_irq.h"
+#include "sys/alt_alarm.h"
+#include "sys/alt_stdio.h"
+
+#define PIO_REGS 4
+
+static const char* const pio_names[HAL_PIO_NUM] = {
+  "KEY", "SW", "LEDR", "LEDG", "HEX_LOW", "HEX_HIGH"
+};
+
+static volatile alt_u32 pio[HAL_PIO_NUM][PIO_REGS];
+static int trace;
+static int count;
+static alt_u32 pio_reads[HAL_PIO_NUM];
+static alt_u32 pio_writes[HAL_PIO_NUM];
+
+static struct {
+  alt_isr_func handler;
+  void* context;
+} irqs[ALT_NIRQ];
+
+static alt_alarm* alarms;
+static volatile alt_u32 nticks;
+
+void hal_stop(void);
+
+/*
+ * Interrupts
+ */
+int alt_irq_register(alt_u32 id, void* context, alt_isr_func handler)
+{
+  OS_CPU_SR cpu_sr;
+
+  if (id >= ALT_NIRQ)
+    return -1;
+  OS_ENTER_CRITICAL();
+  irqs[id].handler = handler;
+  irqs[id].context = context;
+  OS_EXIT_CRITICAL();
+  return 0;
+}
+
+/* Runs the handler of 'id' if the PIO at 'base' requests an interrupt */
+static void pio_irq(int base, alt_u32 id)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  if ((pio[base][ALTERA_AVALON_PIO_EDGE_CAP] & pio[base][ALTERA_AVALON_PIO_IRQ_MASK]) &&
+      irqs[id].handler) {
+    OSIntEnter();
+    irqs[id].handler(irqs[id].context, id);
+    OSIntExit();
+  }
+  OS_EXIT_CRITICAL();
+}
+
+/*
+ * PIOs
+ */
+alt_u32 hal_pio_read(int base, int reg)
+{
+  if (count && reg == ALTERA_AVALON_PIO_DATA)
+    __sync_fetch_and_add(&pio_reads[base], 1);
+  return pio[base][reg];
+}
+
+void hal_pio_write(int base, int reg, alt_u32 data)
+{
+  if (reg == ALTERA_AVALON_PIO_EDGE_CAP) {
+    pio[base][reg] = 0;
+    return;
+  }
+  if (count && reg == ALTERA_AVALON_PIO_DATA)
+    __sync_fetch_and_add(&pio_writes[base], 1);
+  if (trace && reg == ALTERA_AVALON_PIO_DATA && pio[base][reg] != data)
+    fprintf(stderr, "[%lu] %s %08lx\n", (unsigned long) nticks, pio_names[base],
+            (unsigned long) data);
+  pio[base][reg] = data;
+}
+
+/* Presses and releases the keys in 'mask', also used by host test drivers */
+void hal_keys_click(alt_u32 mask)
+{
+  OS_CPU_SR cpu_sr;
+
+  mask &= 0xf;
+  OS_ENTER_CRITICAL();
+  pio[D2_PIO_KEYS4_BASE][ALTERA_AVALON_PIO_DATA] &= ~mask;
+  pio[D2_PIO_KEYS4_BASE][ALTERA_AVALON_PIO_EDGE_CAP] |= mask;
+  OS_EXIT_CRITICAL();
+  pio_irq(D2_PIO_KEYS4_BASE, D2_PIO_KEYS4_IRQ);
+  OS_ENTER_CRITICAL();
+  pio[D2_PIO_KEYS4_BASE][ALTERA_AVALON_PIO_DATA] |= mask;
+  OS_EXIT_CRITICAL();
+}
+
+static void* input_thread(void* arg)
+{
+  char line[128];
+  unsigned long value;
+  char cmd;
+
+  (void) arg;
+  while (fgets(line, sizeof(line), stdin)) {
+    if (sscanf(line, " %c %li", &cmd, (long*) &value) < 1)
+      continue;
+    switch (cmd) {
+    case 'k':
+      hal_keys_click((alt_u32) value);
+      break;
+    case 's':
+      pio[DE2_PIO_TOGGLES18_BASE][ALTERA_AVALON_PIO_DATA] = (alt_u32) value & 0x3ffff;
+      break;
+    case 'q':
+      hal_stop();
+      _exit(0);
+    }
+  }
+  return NULL;
+}
+
+/*
+ * System clock and alarms
+ */
+alt_u32 alt_ticks_per_second(void)
+{
+  return OS_TICKS_PER_SEC;
+}
+
+alt_u32 alt_nticks(void)
+{
+  return nticks;
+}
+
+int alt_alarm_start(alt_alarm* alarm, alt_u32 n, alt_u32 (*callback)(void* context), void* context)
+{
+  OS_CPU_SR cpu_sr;
+
+  if (!alarm || !callback)
+    return -1;
+  OS_ENTER_CRITICAL();
+  alarm->time = nticks + (n ? n : 1);
+  alarm->callback = callback;
+  alarm->context = context;
+  alarm->next = alarms;
+  alarms = alarm;
+  OS_EXIT_CRITICAL();
+  return 0;
+}
+
+void alt_alarm_stop(alt_alarm* alarm)
+{
+  alt_alarm** p;
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  for (p = &alarms; *p; p = &(*p)->next)
+    if (*p == alarm) {
+      *p = alarm->next;
+      break;
+    }
+  OS_EXIT_CRITICAL();
+}
+
+static void clock_tick(void)
+{
+  alt_alarm** p;
+  alt_alarm* a;
+  alt_u32 next;
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  OSIntEnter();
+  nticks++;
+  OSTimeTick();
+  for (p = &alarms; (a = *p) != NULL; ) {
+    if (a->time == nticks) {
+      next = a->callback(a->context);
+      if (next == 0) {
+        *p = a->next;
+        continue;
+      }
+      a->time += next;
+    }
+    p = &a->next;
+  }
+  OSIntExit();
+  OS_EXIT_CRITICAL();
+}
+
+static void* clock_thread(void* arg)
+{
+  struct timespec next, now;
+  long period_ns = 1000000000L / OS_TICKS_PER_SEC;
+
+  (void) arg;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  for (;;) {
+    next.tv_nsec += period_ns;
+    if (next.tv_nsec >= 1000000000L) {
+      next.tv_nsec -= 1000000000L;
+      next.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    clock_tick();
+    /* catch up on ticks lost to host scheduling */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    while (now.tv_sec > next.tv_sec ||
+           (now.tv_sec == next.tv_sec && now.tv_nsec >= next.tv_nsec + period_ns)) {
+      next.tv_nsec += period_ns;
+      if (next.tv_nsec >= 1000000000L) {
+        next.tv_nsec -= 1000000000L;
+        next.tv_sec++;
+      }
+      clock_tick();
+    }
+  }
+  return NULL;
+}
+
+int alt_printf(const char* format, ...)
+{
+  va_list ap;
+  int n;
+
+  va_start(ap, format);
+  n = vprintf(format, ap);
+  va_end(ap);
+  return n;
+}
+
+/* Called before the process exits */
+void hal_stop(void)
+{
+  alt_u32 ticks = nticks;
+  int i;
+
+  fflush(stdout);
+  if (!count)
+    return;
+  fprintf(stderr, "PIO data accesses in %lu ms\n%-9s %8s %8s %10s\n",
+          (unsigned long) (ticks * 1000 / OS_TICKS_PER_SEC), "PIO", "reads", "writes",
+          "writes/s");
+  for (i = 0; i < HAL_PIO_NUM; ++i)
+    fprintf(stderr, "%-9s %8lu %8lu %10.1f\n", pio_names[i], (unsigned long) pio_reads[i],
+            (unsigned long) pio_writes[i],
+            ticks ? (double) pio_writes[i] * OS_TICKS_PER_SEC / ticks : 0.0);
+}
+
+/* Called by OSStart() */
+void hal_start(void)
+{
+  pthread_t thread;
+
+  trace = getenv("HAL_TRACE") != NULL;
+  count = getenv("HAL_COUNT") != NULL;
+  pio[D2_PIO_KEYS4_BASE][ALTERA_AVALON_PIO_DATA] |= 0xf; /* keys released */
+
+  pthread_create(&thread, NULL, clock_thread, NULL);
+  pthread_detach(thread);
+  pthread_create(&thread, NULL, input_thread, NULL);
+  pthread_detach(thread);
+}
@@ -0,0 +1,29 @@
+#ifndef ALTERA_AVALON_PIO_REGS_H_
+#define ALTERA_AVALON_PIO_REGS_H_
+
+/*
+ * Host version of the Avalon PIO register access macros. The registers
+ * live in the PIO model of hal_posix.c.
+ */
+
+#include "alt_types.h"
+
+#define ALTERA_AVALON_PIO_DATA      0
+#define ALTERA_AVALON_PIO_DIRECTION 1
+#define ALTERA_AVALON_PIO_IRQ_MASK  2
+#define ALTERA_AVALON_PIO_EDGE_CAP  3
+
+alt_u32 hal_pio_read(int base, int reg);
+void    hal_pio_write(int base, int reg, alt_u32 data);
+void    hal_keys_click(alt_u32 mask); /* press and release KEY PIO inputs */
+
+#define IORD_ALTERA_AVALON_PIO_DATA(base)            hal_pio_read(base, ALTERA_AVALON_PIO_DATA)
+#define IOWR_ALTERA_AVALON_PIO_DATA(base, data)      hal_pio_write(base, ALTERA_AVALON_PIO_DATA, data)
+#define IORD_ALTERA_AVALON_PIO_DIRECTION(base)       hal_pio_read(base, ALTERA_AVALON_PIO_DIRECTION)
+#define IOWR_ALTERA_AVALON_PIO_DIRECTION(base, data) hal_pio_write(base, ALTERA_AVALON_PIO_DIRECTION, data)
+#define IORD_ALTERA_AVALON_PIO_IRQ_MASK(base)        hal_pio_read(base, ALTERA_AVALON_PIO_IRQ_MASK)
+#define IOWR_ALTERA_AVALON_PIO_IRQ_MASK(base, data)  hal_pio_write(base, ALTERA_AVALON_PIO_IRQ_MASK, data)
+#define IORD_ALTERA_AVALON_PIO_EDGE_CAP(base)        hal_pio_read(base, ALTERA_AVALON_PIO_EDGE_CAP)
+#define IOWR_ALTERA_AVALON_PIO_EDGE_CAP(base, data)  hal_pio_write(base, ALTERA_AVALON_PIO_EDGE_CAP, data)
+
+#endif /*ALTERA_AVALON_PIO_REGS_H_*/
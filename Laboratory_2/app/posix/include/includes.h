@@ -0,0 +1,11 @@
+#ifndef INCLUDES_H_
+#define INCLUDES_H_
+
+/* Host version of the uC/OS-II BSP master include file */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "ucos_ii.h"
+
+#endif /*INCLUDES_H_*/
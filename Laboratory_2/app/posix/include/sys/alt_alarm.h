@@ -0,0 +1,25 @@
+#ifndef ALT_ALARM_H_
+#define ALT_ALARM_H_
+
+/*
+ * Host version of the HAL alarms. Callbacks run from the system clock
+ * tick, like on the board, and return the number of ticks until the
+ * next call (0 stops the alarm).
+ */
+
+#include "alt_types.h"
+
+typedef struct alt_alarm_s {
+  struct alt_alarm_s* next;
+  alt_u32 time;                        /* tick of the next call */
+  alt_u32 (*callback)(void* context);
+  void* context;
+} alt_alarm;
+
+int     alt_alarm_start(alt_alarm* alarm, alt_u32 nticks,
+                        alt_u32 (*callback)(void* context), void* context);
+void    alt_alarm_stop(alt_alarm* alarm);
+alt_u32 alt_ticks_per_second(void);
+alt_u32 alt_nticks(void);
+
+#endif /*ALT_ALARM_H_*/
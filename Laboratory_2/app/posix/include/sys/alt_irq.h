@@ -0,0 +1,18 @@
+#ifndef ALT_IRQ_H_
+#define ALT_IRQ_H_
+
+/*
+ * Host version of the legacy HAL interrupt API. Handlers run on the
+ * thread that raises the interrupt, with the kernel lock held, between
+ * OSIntEnter() and OSIntExit().
+ */
+
+#include "alt_types.h"
+
+#define ALT_NIRQ 32
+
+typedef void (*alt_isr_func)(void* context, alt_u32 id);
+
+int alt_irq_register(alt_u32 id, void* context, alt_isr_func handler);
+
+#endif /*ALT_IRQ_H_*/
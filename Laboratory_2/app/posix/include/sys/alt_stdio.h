@@ -0,0 +1,8 @@
+#ifndef ALT_STDIO_H_
+#define ALT_STDIO_H_
+
+/* Host version of the small HAL printf */
+
+int alt_printf(const char* format, ...);
+
+#endif /*ALT_STDIO_H_*/
@@ -0,0 +1,23 @@
+#ifndef SYSTEM_H_
+#define SYSTEM_H_
+
+/*
+ * Host version of the generated system.h of the DE2 Nios II system.
+ *
+ * The PIO base addresses are indices into the register file emulated by
+ * hal_posix.c, the IRQ numbers index its handler table.
+ */
+
+#define ALT_CPU_FREQ 50000000
+
+#define D2_PIO_KEYS4_BASE        0
+#define D2_PIO_KEYS4_IRQ         3
+#define DE2_PIO_TOGGLES18_BASE   1
+#define DE2_PIO_REDLED18_BASE    2
+#define DE2_PIO_GREENLED9_BASE   3
+#define DE2_PIO_HEX_LOW28_BASE   4
+#define DE2_PIO_HEX_HIGH28_BASE  5
+
+#define HAL_PIO_NUM              6
+
+#endif /*SYSTEM_H_*/
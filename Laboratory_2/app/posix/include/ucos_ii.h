@@ -0,0 +1,293 @@
+#ifndef UCOS_II_H_
+#define UCOS_II_H_
+
+/*
+ * uC/OS-II API subset of the POSIX host port (see ../os_posix.c).
+ *
+ * Names, types, option and error codes follow uC/OS-II V2.86 as
+ * configured in the Nios II BSP, so that the lab applications compile
+ * unchanged. Only the services used by the applications are provided.
+ */
+
+#include "alt_types.h"
+
+/*
+ * Configuration (os_cfg.h)
+ */
+#define OS_VERSION               286
+#define OS_LOWEST_PRIO           20
+#define OS_MAX_TASKS             (OS_LOWEST_PRIO + 1)
+#define OS_TICKS_PER_SEC         1000
+#define OS_TMR_EN                1
+#define OS_TMR_CFG_TICKS_PER_SEC 10
+#define OS_TASK_TMR_PRIO         0
+#define OS_TASK_IDLE_PRIO        OS_LOWEST_PRIO
+#define OS_FLAGS_NBITS           16
+#define OS_APP_HOOKS_EN          1
+
+/*
+ * Data types (os_cpu.h)
+ */
+typedef unsigned char  BOOLEAN;
+typedef unsigned char  INT8U;
+typedef signed   char  INT8S;
+typedef unsigned short INT16U;
+typedef signed   short INT16S;
+typedef unsigned int   INT32U;
+typedef signed   int   INT32S;
+typedef float          FP32;
+typedef double         FP64;
+typedef INT32U         OS_STK;
+typedef INT32U         OS_CPU_SR;
+typedef INT16U         OS_FLAGS;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+/*
+ * Critical sections take the kernel lock, which also keeps the emulated
+ * interrupts out. Leaving the outermost one is a scheduling point.
+ */
+#define OS_CRITICAL_METHOD 3
+
+OS_CPU_SR OSCPUSaveSR(void);
+void      OSCPURestoreSR(OS_CPU_SR cpu_sr);
+
+#define OS_ENTER_CRITICAL() { cpu_sr = OSCPUSaveSR(); }
+#define OS_EXIT_CRITICAL()  { OSCPURestoreSR(cpu_sr); }
+
+/*
+ * Error codes
+ */
+#define OS_ERR_NONE            0u
+#define OS_ERR_EVENT_TYPE      1u
+#define OS_ERR_PEND_ISR        2u
+#define OS_ERR_POST_NULL_PTR   3u
+#define OS_ERR_PEVENT_NULL     4u
+#define OS_ERR_POST_ISR        5u
+#define OS_ERR_INVALID_OPT     7u
+#define OS_ERR_TIMEOUT        10u
+#define OS_ERR_PEND_LOCKED    13u
+#define OS_ERR_CREATE_ISR     16u
+#define OS_ERR_MBOX_FULL      20u
+#define OS_ERR_Q_FULL         30u
+#define OS_ERR_Q_EMPTY        31u
+#define OS_ERR_PRIO_EXIST     40u
+#define OS_ERR_PRIO           41u
+#define OS_ERR_PRIO_INVALID   42u
+#define OS_ERR_SEM_OVF        50u
+#define OS_ERR_TASK_DEL_IDLE  62u
+#define OS_ERR_TASK_NOT_EXIST 67u
+#define OS_ERR_TASK_OPT       69u
+#define OS_ERR_MEM_INVALID_PART   110u
+#define OS_ERR_MEM_INVALID_BLKS   111u
+#define OS_ERR_MEM_INVALID_SIZE   112u
+#define OS_ERR_MEM_NO_FREE_BLKS   113u
+#define OS_ERR_MEM_FULL           114u
+#define OS_ERR_MEM_INVALID_PBLK   115u
+#define OS_ERR_MEM_INVALID_PMEM   116u
+#define OS_ERR_MEM_INVALID_PDATA  117u
+#define OS_ERR_MEM_INVALID_ADDR   118u
+#define OS_ERR_TMR_INVALID_DLY    130u
+#define OS_ERR_TMR_INVALID_PERIOD 131u
+#define OS_ERR_TMR_INVALID_OPT    132u
+#define OS_ERR_TMR_INVALID        138u
+#define OS_ERR_TMR_NON_AVAIL      139u
+#define OS_ERR_FLAG_WAIT_TYPE     151u
+#define OS_ERR_FLAG_NOT_RDY       152u
+#define OS_ERR_FLAG_GRP_DEPLETED  154u
+
+/* pre-V2.84 names */
+#define OS_NO_ERR             OS_ERR_NONE
+#define OS_TIMEOUT            OS_ERR_TIMEOUT
+#define OS_MBOX_FULL          OS_ERR_MBOX_FULL
+#define OS_Q_FULL             OS_ERR_Q_FULL
+#define OS_PRIO_EXIST         OS_ERR_PRIO_EXIST
+#define OS_PRIO_INVALID       OS_ERR_PRIO_INVALID
+#define OS_TASK_NOT_EXIST     OS_ERR_TASK_NOT_EXIST
+#define OS_SEM_OVF            OS_ERR_SEM_OVF
+#define OS_FLAG_ERR_NOT_RDY   OS_ERR_FLAG_NOT_RDY
+#define OS_MEM_INVALID_PART   OS_ERR_MEM_INVALID_PART
+#define OS_MEM_INVALID_BLKS   OS_ERR_MEM_INVALID_BLKS
+#define OS_MEM_INVALID_SIZE   OS_ERR_MEM_INVALID_SIZE
+#define OS_MEM_NO_FREE_BLKS   OS_ERR_MEM_NO_FREE_BLKS
+#define OS_MEM_FULL           OS_ERR_MEM_FULL
+#define OS_MEM_INVALID_PBLK   OS_ERR_MEM_INVALID_PBLK
+#define OS_MEM_INVALID_PMEM   OS_ERR_MEM_INVALID_PMEM
+#define OS_MEM_INVALID_PDATA  OS_ERR_MEM_INVALID_PDATA
+#define OS_MEM_INVALID_ADDR   OS_ERR_MEM_INVALID_ADDR
+
+/*
+ * Options
+ */
+#define OS_PRIO_SELF          0xFFu
+
+#define OS_TASK_OPT_NONE      0x0000u
+#define OS_TASK_OPT_STK_CHK   0x0001u
+#define OS_TASK_OPT_STK_CLR   0x0002u
+#define OS_TASK_OPT_SAVE_FP   0x0004u
+
+#define OS_FLAG_WAIT_CLR_ALL  0u
+#define OS_FLAG_WAIT_CLR_ANY  1u
+#define OS_FLAG_WAIT_SET_ALL  2u
+#define OS_FLAG_WAIT_SET_ANY  3u
+#define OS_FLAG_CONSUME       0x80u
+#define OS_FLAG_CLR           0u
+#define OS_FLAG_SET           1u
+
+#define OS_TMR_OPT_NONE       0u
+#define OS_TMR_OPT_ONE_SHOT   1u
+#define OS_TMR_OPT_PERIODIC   2u
+
+#define OS_TMR_STATE_UNUSED   0u
+#define OS_TMR_STATE_STOPPED  1u
+#define OS_TMR_STATE_COMPLETED 2u
+#define OS_TMR_STATE_RUNNING  3u
+
+/*
+ * Kernel objects
+ */
+#define OS_EVENT_TYPE_UNUSED  0u
+#define OS_EVENT_TYPE_MBOX    1u
+#define OS_EVENT_TYPE_Q       2u
+#define OS_EVENT_TYPE_SEM     3u
+#define OS_EVENT_TYPE_FLAG    5u
+
+typedef struct os_event {
+  INT8U   OSEventType;
+  void*   OSEventPtr;   /* mailbox message or queue descriptor */
+  INT16U  OSEventCnt;   /* semaphore count */
+} OS_EVENT;
+
+typedef struct os_q {
+  void**  OSQStart;
+  void**  OSQEnd;
+  void**  OSQIn;
+  void**  OSQOut;
+  INT16U  OSQSize;
+  INT16U  OSQEntries;
+} OS_Q;
+
+typedef struct os_flag_grp {
+  INT8U    OSFlagType;
+  OS_FLAGS OSFlagFlags;
+} OS_FLAG_GRP;
+
+typedef struct os_mem {
+  void*   OSMemAddr;     /* first block */
+  void*   OSMemFreeList; /* free blocks, linked through their first word */
+  INT32U  OSMemBlkSize;
+  INT32U  OSMemNBlks;
+  INT32U  OSMemNFree;
+} OS_MEM;
+
+typedef struct os_mem_data {
+  void*   OSAddr;
+  void*   OSFreeList;
+  INT32U  OSBlkSize;
+  INT32U  OSNBlks;
+  INT32U  OSNFree;
+  INT32U  OSNUsed;
+} OS_MEM_DATA;
+
+typedef void (*OS_TMR_CALLBACK)(void* ptmr, void* parg);
+
+typedef struct os_tmr {
+  struct os_tmr*  OSTmrNext;
+  OS_TMR_CALLBACK OSTmrCallback;
+  void*           OSTmrCallbackArg;
+  INT32U          OSTmrMatch;     /* timer tick of the next expiry */
+  INT32U          OSTmrDly;
+  INT32U          OSTmrPeriod;
+  INT8U*          OSTmrName;
+  INT8U           OSTmrOpt;
+  INT8U           OSTmrState;
+} OS_TMR;
+
+typedef struct os_stk_data {
+  INT32U OSFree;  /* bytes */
+  INT32U OSUsed;  /* bytes */
+} OS_STK_DATA;
+
+typedef struct os_tcb OS_TCB; /* private to the port */
+
+/*
+ * Kernel variables
+ */
+extern volatile INT32U  OSIdleCtr;
+extern volatile INT32U  OSIdleCtrMax;
+extern volatile INT32U  OSCtxSwCtr;
+extern volatile INT8U   OSCPUUsage;
+extern volatile BOOLEAN OSRunning;
+extern volatile INT8U   OSIntNesting;
+extern volatile INT8U   OSPrioCur;
+extern volatile INT8U   OSPrioHighRdy;
+
+/*
+ * Services
+ */
+void      OSInit(void);
+void      OSStart(void);
+void      OSStatInit(void);
+void      OSIntEnter(void);
+void      OSIntExit(void);
+void      OSSchedLock(void);
+void      OSSchedUnlock(void);
+
+/* application hooks, called by the port with OS_APP_HOOKS_EN */
+void      App_TaskCreateHook(OS_TCB* ptcb);
+void      App_TaskDelHook(OS_TCB* ptcb);
+void      App_TaskIdleHook(void);
+void      App_TaskStatHook(void);
+void      App_TaskSwHook(void);
+void      App_TCBInitHook(OS_TCB* ptcb);
+void      App_TimeTickHook(void);
+
+INT8U     OSTaskCreate(void (*task)(void* p_arg), void* p_arg, OS_STK* ptos, INT8U prio);
+INT8U     OSTaskCreateExt(void (*task)(void* p_arg), void* p_arg, OS_STK* ptos, INT8U prio,
+                          INT16U id, OS_STK* pbos, INT32U stk_size, void* pext, INT16U opt);
+INT8U     OSTaskDel(INT8U prio);
+INT8U     OSTaskSuspend(INT8U prio);
+INT8U     OSTaskResume(INT8U prio);
+INT8U     OSTaskStkChk(INT8U prio, OS_STK_DATA* p_stk_data);
+
+void      OSTimeDly(INT16U ticks);
+INT8U     OSTimeDlyHMSM(INT8U hours, INT8U minutes, INT8U seconds, INT16U ms);
+INT32U    OSTimeGet(void);
+void      OSTimeTick(void);
+
+OS_EVENT* OSSemCreate(INT16U cnt);
+void      OSSemPend(OS_EVENT* pevent, INT16U timeout, INT8U* perr);
+INT16U    OSSemAccept(OS_EVENT* pevent);
+INT8U     OSSemPost(OS_EVENT* pevent);
+
+OS_EVENT* OSMboxCreate(void* pmsg);
+void*     OSMboxPend(OS_EVENT* pevent, INT16U timeout, INT8U* perr);
+void*     OSMboxAccept(OS_EVENT* pevent);
+INT8U     OSMboxPost(OS_EVENT* pevent, void* pmsg);
+
+OS_EVENT* OSQCreate(void** start, INT16U size);
+void*     OSQPend(OS_EVENT* pevent, INT16U timeout, INT8U* perr);
+void*     OSQAccept(OS_EVENT* pevent, INT8U* perr);
+INT8U     OSQPost(OS_EVENT* pevent, void* pmsg);
+
+OS_MEM*   OSMemCreate(void* addr, INT32U nblks, INT32U blksize, INT8U* perr);
+void*     OSMemGet(OS_MEM* pmem, INT8U* perr);
+INT8U     OSMemPut(OS_MEM* pmem, void* pblk);
+INT8U     OSMemQuery(OS_MEM* pmem, OS_MEM_DATA* p_mem_data);
+
+OS_FLAG_GRP* OSFlagCreate(OS_FLAGS flags, INT8U* perr);
+OS_FLAGS  OSFlagPend(OS_FLAG_GRP* pgrp, OS_FLAGS flags, INT8U wait_type, INT16U timeout, INT8U* perr);
+OS_FLAGS  OSFlagAccept(OS_FLAG_GRP* pgrp, OS_FLAGS flags, INT8U wait_type, INT8U* perr);
+OS_FLAGS  OSFlagPost(OS_FLAG_GRP* pgrp, OS_FLAGS flags, INT8U opt, INT8U* perr);
+OS_FLAGS  OSFlagQuery(OS_FLAG_GRP* pgrp, INT8U* perr);
+
+OS_TMR*   OSTmrCreate(INT32U dly, INT32U period, INT8U opt, OS_TMR_CALLBACK callback,
+                      void* callback_arg, INT8U* pname, INT8U* perr);
+BOOLEAN   OSTmrStart(OS_TMR* ptmr, INT8U* perr);
+BOOLEAN   OSTmrStop(OS_TMR* ptmr, INT8U opt, void* callback_arg, INT8U* perr);
+INT8U     OSTmrSignal(void);
+
+#endif /*UCOS_II_H_*/
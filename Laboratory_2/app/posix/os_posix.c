@@ -0,0 +1,1123 @@
+/* POSIX host port of the uC/OS-II API subset used by the lab applications
+ *
+ * Description:
+ *
+ *   Every uC/OS-II task is a pthread, but only one of them runs at a time:
+ *   the one OSTCBCur points to. All kernel state is protected by one
+ *   mutex, the kernel lock. A task that is not current waits on a
+ *   condition variable until the scheduler makes it current again.
+ *
+ *   The scheduler runs whenever a task leaves a kernel service or its
+ *   outermost critical section. It always picks the highest priority
+ *   ready task, so strict priority order holds at every kernel call.
+ *   Interrupts (the system clock tick and the emulated PIOs, see
+ *   hal_posix.c) run on their own threads. They hold the kernel lock,
+ *   which plays the role of disabled interrupts, between OSIntEnter()
+ *   and OSIntExit(). When an interrupt readies a higher priority task,
+ *   the running task is preempted at its next kernel call or critical
+ *   section. A long computation without any kernel call delays the
+ *   preemption until it ends; this is the one difference to the board.
+ *
+ *   The idle task counts OSIdleCtr and calls App_TaskIdleHook() like the
+ *   real one and, like the board, keeps one CPU busy. After OSStatInit()
+ *   OSIdleCtr is cleared every 100 ms as the statistics task does. Every
+ *   task switch calls App_TaskSwHook() with OSPrioCur and OSPrioHighRdy
+ *   set, as OSTaskSwHook() does; the other hooks and OSCPUUsage are not
+ *   provided. OS timers are run by a timer task at
+ *   OS_TASK_TMR_PRIO that is signalled by OSTmrSignal().
+ *
+ *   Task stacks are host thread stacks of OS_HOST_STACK bytes. The stack
+ *   passed to OSTaskCreateExt() is not used; OSTaskStkChk() reports the
+ *   high-water mark of the host stack against the size of the target
+ *   stack, so the figures are those of the host ABI.
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdarg.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "includes.h"
+
+#define OS_HOST_STACK (256 * 1024)
+
+/* Task states, pend bits and suspension may be combined */
+#define OS_STAT_RDY      0x00u
+#define OS_STAT_SEM      0x01u
+#define OS_STAT_MBOX     0x02u
+#define OS_STAT_Q        0x04u
+#define OS_STAT_SUSPEND  0x08u
+#define OS_STAT_FLAG     0x20u
+#define OS_STAT_PEND_ANY (OS_STAT_SEM | OS_STAT_MBOX | OS_STAT_Q | OS_STAT_FLAG)
+
+struct os_tcb {
+  INT8U        prio;
+  INT8U        stat;
+  BOOLEAN      pend_to;    /* the last pend timed out */
+  BOOLEAN      deleted;
+  INT32U       dly;        /* ticks until the delay or pend timeout ends */
+  OS_EVENT*    event;      /* event waited for */
+  void*        msg;        /* message received */
+  OS_FLAG_GRP* flag_grp;   /* flag group waited for */
+  OS_FLAGS     flag_wait;
+  INT8U        flag_type;
+  OS_FLAGS     flag_rdy;   /* flags that made the task ready */
+  void       (*task)(void* p_arg);
+  void*        p_arg;
+  pthread_t    thread;
+  char*        stack;      /* host stack */
+  INT32U       stk_bytes;  /* size of the target stack */
+};
+
+volatile INT32U  OSIdleCtr;
+volatile INT32U  OSIdleCtrMax;
+volatile INT32U  OSCtxSwCtr;
+volatile INT8U   OSCPUUsage;
+volatile BOOLEAN OSRunning;
+volatile INT8U   OSIntNesting;
+volatile INT8U   OSPrioCur;
+volatile INT8U   OSPrioHighRdy;
+
+static OS_TCB* OSTCBPrioTbl[OS_LOWEST_PRIO + 1];
+static BOOLEAN os_stat_rdy; /* OSStatInit() has run */
+static OS_TCB* OSTCBCur;
+static INT8U   OSLockNesting;
+static INT32U  OSTime;
+
+static pthread_mutex_t os_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  os_cond = PTHREAD_COND_INITIALIZER;
+static __thread int     os_depth; /* kernel lock nesting of this thread */
+static __thread OS_TCB* os_self;  /* TCB of this thread, NULL for interrupts */
+
+/*
+ * Kernel lock
+ */
+static void os_lock(void)
+{
+  if (os_depth++ == 0)
+    pthread_mutex_lock(&os_mutex);
+}
+
+static void os_unlock(void)
+{
+  if (--os_depth == 0)
+    pthread_mutex_unlock(&os_mutex);
+}
+
+static BOOLEAN os_ready(const OS_TCB* t)
+{
+  return t && t->stat == OS_STAT_RDY && t->dly == 0 && !t->deleted;
+}
+
+static OS_TCB* os_highest(void)
+{
+  int p;
+
+  for (p = 0; p <= OS_LOWEST_PRIO; ++p)
+    if (os_ready(OSTCBPrioTbl[p]))
+      return OSTCBPrioTbl[p];
+  return NULL;
+}
+
+/* Blocks the calling task until it is current again */
+static void os_wait_cpu(OS_TCB* self)
+{
+  while (OSTCBCur != self || !OSRunning) {
+    if (self->deleted) {
+      pthread_mutex_unlock(&os_mutex);
+      pthread_exit(NULL);
+    }
+    pthread_cond_wait(&os_cond, &os_mutex);
+  }
+}
+
+/* empty unless the application provides its hooks (app_hooks.c) */
+__attribute__((weak)) void App_TaskIdleHook(void)
+{
+}
+
+__attribute__((weak)) void App_TaskSwHook(void)
+{
+}
+
+/*
+ * Makes the highest priority ready task current. Called with the kernel
+ * lock held; in task context the caller then waits until it is current
+ * again, which returns at once if no other task was chosen.
+ */
+static void os_sched(void)
+{
+  OS_TCB* self = os_self;
+  OS_TCB* next;
+
+  if (!OSRunning || OSIntNesting || !self)
+    return;
+  if (OSLockNesting && os_ready(self))
+    return;
+  next = os_highest();
+  if (next != OSTCBCur) {
+    OSPrioHighRdy = next->prio;
+#if OS_APP_HOOKS_EN > 0
+    App_TaskSwHook(); /* as OSTaskSwHook(), before the switch */
+#endif
+    OSTCBCur = next;
+    OSPrioCur = next->prio;
+    OSCtxSwCtr++;
+    pthread_cond_broadcast(&os_cond);
+  }
+  os_wait_cpu(self);
+}
+
+/* Leaves a kernel service: scheduling point */
+static void os_exit(void)
+{
+  if (os_depth == 1)
+    os_sched();
+  os_unlock();
+}
+
+OS_CPU_SR OSCPUSaveSR(void)
+{
+  os_lock();
+  return 0;
+}
+
+void OSCPURestoreSR(OS_CPU_SR cpu_sr)
+{
+  (void) cpu_sr;
+  os_exit();
+}
+
+/*
+ * Interrupts: the HAL takes the kernel lock around OSIntEnter() and
+ * OSIntExit(). Rescheduling is left to the running task.
+ */
+void OSIntEnter(void)
+{
+  os_lock();
+  OSIntNesting++;
+  os_unlock();
+}
+
+void OSIntExit(void)
+{
+  os_lock();
+  if (OSIntNesting)
+    OSIntNesting--;
+  os_unlock();
+}
+
+void OSSchedLock(void)
+{
+  os_lock();
+  if (OSRunning && OSLockNesting < 255)
+    OSLockNesting++;
+  os_unlock();
+}
+
+void OSSchedUnlock(void)
+{
+  os_lock();
+  if (OSLockNesting)
+    OSLockNesting--;
+  os_exit();
+}
+
+/*
+ * Tasks
+ */
+static void* os_task_thread(void* p)
+{
+  OS_TCB* self = (OS_TCB*) p;
+
+  os_self = self;
+  os_lock();
+  os_wait_cpu(self);
+  os_unlock();
+
+  self->task(self->p_arg);
+
+  /* a task must not return, delete it if it does */
+  OSTaskDel(OS_PRIO_SELF);
+  return NULL;
+}
+
+INT8U OSTaskCreateExt(void (*task)(void* p_arg), void* p_arg, OS_STK* ptos, INT8U prio,
+                      INT16U id, OS_STK* pbos, INT32U stk_size, void* pext, INT16U opt)
+{
+  pthread_attr_t attr;
+  OS_TCB* t;
+
+  (void) ptos; (void) id; (void) pbos; (void) pext; (void) opt;
+
+  if (prio > OS_LOWEST_PRIO)
+    return OS_ERR_PRIO_INVALID;
+
+  os_lock();
+  if (OSIntNesting) {
+    os_unlock();
+    return OS_ERR_CREATE_ISR;
+  }
+  if (OSTCBPrioTbl[prio]) {
+    os_unlock();
+    return OS_ERR_PRIO_EXIST;
+  }
+
+  t = calloc(1, sizeof(*t));
+  if (t)
+    t->stack = mmap(NULL, OS_HOST_STACK, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  if (!t || t->stack == MAP_FAILED) {
+    os_unlock();
+    fprintf(stderr, "os_posix: out of memory for task %d\n", prio);
+    exit(1);
+  }
+  t->prio = prio;
+  t->task = task;
+  t->p_arg = p_arg;
+  t->stk_bytes = stk_size * sizeof(OS_STK);
+  OSTCBPrioTbl[prio] = t;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstack(&attr, t->stack, OS_HOST_STACK);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  if (pthread_create(&t->thread, &attr, os_task_thread, t) != 0) {
+    fprintf(stderr, "os_posix: cannot create the thread of task %d\n", prio);
+    exit(1);
+  }
+  pthread_attr_destroy(&attr);
+
+  os_exit();
+  return OS_ERR_NONE;
+}
+
+INT8U OSTaskCreate(void (*task)(void* p_arg), void* p_arg, OS_STK* ptos, INT8U prio)
+{
+  return OSTaskCreateExt(task, p_arg, ptos, prio, prio, ptos, 0, NULL, OS_TASK_OPT_NONE);
+}
+
+INT8U OSTaskDel(INT8U prio)
+{
+  OS_TCB* t;
+
+  os_lock();
+  if (prio == OS_PRIO_SELF)
+    prio = os_self ? os_self->prio : OS_LOWEST_PRIO + 1;
+  if (prio == OS_TASK_IDLE_PRIO) {
+    os_unlock();
+    return OS_ERR_TASK_DEL_IDLE;
+  }
+  if (prio > OS_LOWEST_PRIO || !(t = OSTCBPrioTbl[prio])) {
+    os_unlock();
+    return OS_ERR_TASK_NOT_EXIST;
+  }
+  OSTCBPrioTbl[prio] = NULL;
+  t->deleted = TRUE;
+
+  if (t == os_self) {
+    OSTCBCur = os_highest();
+    OSPrioCur = OSTCBCur->prio;
+    OSCtxSwCtr++;
+    pthread_cond_broadcast(&os_cond);
+    os_depth = 0;
+    pthread_mutex_unlock(&os_mutex);
+    pthread_exit(NULL);
+  }
+  pthread_cond_broadcast(&os_cond); /* the task's thread exits */
+  os_exit();
+  return OS_ERR_NONE;
+}
+
+INT8U OSTaskSuspend(INT8U prio)
+{
+  OS_TCB* t;
+
+  os_lock();
+  if (prio == OS_PRIO_SELF)
+    prio = os_self ? os_self->prio : OS_LOWEST_PRIO + 1;
+  if (prio == OS_TASK_IDLE_PRIO) {
+    os_unlock();
+    return OS_ERR_PRIO;
+  }
+  if (prio > OS_LOWEST_PRIO || !(t = OSTCBPrioTbl[prio])) {
+    os_unlock();
+    return OS_ERR_TASK_NOT_EXIST;
+  }
+  t->stat |= OS_STAT_SUSPEND;
+  os_exit();
+  return OS_ERR_NONE;
+}
+
+INT8U OSTaskResume(INT8U prio)
+{
+  OS_TCB* t;
+
+  os_lock();
+  if (prio > OS_LOWEST_PRIO || !(t = OSTCBPrioTbl[prio])) {
+    os_unlock();
+    return OS_ERR_TASK_NOT_EXIST;
+  }
+  t->stat &= ~OS_STAT_SUSPEND;
+  os_exit();
+  return OS_ERR_NONE;
+}
+
+INT8U OSTaskStkChk(INT8U prio, OS_STK_DATA* p_stk_data)
+{
+  OS_TCB* t;
+  INT32U free_bytes = 0;
+
+  os_lock();
+  if (prio == OS_PRIO_SELF)
+    prio = os_self ? os_self->prio : OS_LOWEST_PRIO + 1;
+  if (prio > OS_LOWEST_PRIO || !(t = OSTCBPrioTbl[prio])) {
+    os_unlock();
+    return OS_ERR_TASK_NOT_EXIST;
+  }
+  /* the stack grows down from the end of the mapping, which starts zeroed */
+  while (free_bytes < OS_HOST_STACK && t->stack[free_bytes] == 0)
+    free_bytes++;
+  p_stk_data->OSUsed = OS_HOST_STACK - free_bytes;
+  p_stk_data->OSFree = p_stk_data->OSUsed < t->stk_bytes ? t->stk_bytes - p_stk_data->OSUsed : 0;
+  os_exit();
+  return OS_ERR_NONE;
+}
+
+/*
+ * Pending and readying
+ */
+
+/* Blocks the current task on 'stat' until readied or timed out */
+static void os_pend(INT8U stat, OS_EVENT* pevent, INT16U timeout)
+{
+  OS_TCB* self = os_self;
+
+  self->stat |= stat;
+  self->event = pevent;
+  self->dly = timeout;
+  self->pend_to = FALSE;
+  os_sched();
+  self->event = NULL;
+}
+
+/* Readies the highest priority task pending on 'pevent' */
+static OS_TCB* os_event_ready(OS_EVENT* pevent, void* msg, INT8U stat)
+{
+  OS_TCB* t;
+  int p;
+
+  for (p = 0; p <= OS_LOWEST_PRIO; ++p) {
+    t = OSTCBPrioTbl[p];
+    if (t && (t->stat & stat) && t->event == pevent) {
+      t->stat &= ~stat;
+      t->dly = 0;
+      t->msg = msg;
+      return t;
+    }
+  }
+  return NULL;
+}
+
+static OS_EVENT* os_event_create(INT8U type)
+{
+  OS_EVENT* pevent = calloc(1, sizeof(*pevent));
+
+  if (pevent)
+    pevent->OSEventType = type;
+  return pevent;
+}
+
+/*
+ * Time
+ */
+void OSTimeDly(INT16U ticks)
+{
+  if (ticks == 0 || !os_self)
+    return;
+  os_lock();
+  os_self->dly = ticks;
+  os_exit();
+}
+
+INT8U OSTimeDlyHMSM(INT8U hours, INT8U minutes, INT8U seconds, INT16U ms)
+{
+  INT32U ticks;
+
+  if (minutes > 59 || seconds > 59 || ms > 999)
+    return OS_ERR_INVALID_OPT;
+  ticks = ((INT32U) hours * 3600u + (INT32U) minutes * 60u + seconds) * OS_TICKS_PER_SEC
+        + OS_TICKS_PER_SEC * ((INT32U) ms + 500u / OS_TICKS_PER_SEC) / 1000u;
+  while (ticks > 65535u) {
+    OSTimeDly(65535u);
+    ticks -= 65535u;
+  }
+  OSTimeDly((INT16U) ticks);
+  return OS_ERR_NONE;
+}
+
+INT32U OSTimeGet(void)
+{
+  INT32U t;
+
+  os_lock();
+  t = OSTime;
+  os_unlock();
+  return t;
+}
+
+/* Called by the system clock interrupt */
+void OSTimeTick(void)
+{
+  OS_TCB* t;
+  int p;
+
+  os_lock();
+  OSTime++;
+  if (os_stat_rdy && OSTime % (OS_TICKS_PER_SEC / 10) == 0)
+    OSIdleCtr = 0; /* as OS_TaskStat() */
+  for (p = 0; p <= OS_LOWEST_PRIO; ++p) {
+    t = OSTCBPrioTbl[p];
+    if (t && t->dly && --t->dly == 0 && (t->stat & OS_STAT_PEND_ANY)) {
+      t->stat &= ~OS_STAT_PEND_ANY;
+      t->pend_to = TRUE;
+    }
+  }
+  os_unlock();
+}
+
+/*
+ * Semaphores
+ */
+OS_EVENT* OSSemCreate(INT16U cnt)
+{
+  OS_EVENT* pevent = os_event_create(OS_EVENT_TYPE_SEM);
+
+  if (pevent)
+    pevent->OSEventCnt = cnt;
+  return pevent;
+}
+
+void OSSemPend(OS_EVENT* pevent, INT16U timeout, INT8U* perr)
+{
+  if (!pevent) { *perr = OS_ERR_PEVENT_NULL; return; }
+  if (pevent->OSEventType != OS_EVENT_TYPE_SEM) { *perr = OS_ERR_EVENT_TYPE; return; }
+
+  os_lock();
+  if (OSIntNesting || !os_self) {
+    os_unlock();
+    *perr = OS_ERR_PEND_ISR;
+    return;
+  }
+  if (pevent->OSEventCnt > 0) {
+    pevent->OSEventCnt--;
+    *perr = OS_ERR_NONE;
+    os_exit();
+    return;
+  }
+  os_pend(OS_STAT_SEM, pevent, timeout);
+  *perr = os_self->pend_to ? OS_ERR_TIMEOUT : OS_ERR_NONE;
+  os_exit();
+}
+
+INT16U OSSemAccept(OS_EVENT* pevent)
+{
+  INT16U cnt;
+
+  if (!pevent || pevent->OSEventType != OS_EVENT_TYPE_SEM)
+    return 0;
+  os_lock();
+  cnt = pevent->OSEventCnt;
+  if (cnt > 0)
+    pevent->OSEventCnt--;
+  os_unlock();
+  return cnt;
+}
+
+INT8U OSSemPost(OS_EVENT* pevent)
+{
+  if (!pevent) return OS_ERR_PEVENT_NULL;
+  if (pevent->OSEventType != OS_EVENT_TYPE_SEM) return OS_ERR_EVENT_TYPE;
+
+  os_lock();
+  if (!os_event_ready(pevent, NULL, OS_STAT_SEM)) {
+    if (pevent->OSEventCnt == 65535u) {
+      os_unlock();
+      return OS_ERR_SEM_OVF;
+    }
+    pevent->OSEventCnt++;
+  }
+  os_exit();
+  return OS_ERR_NONE;
+}
+
+/*
+ * Mailboxes
+ */
+OS_EVENT* OSMboxCreate(void* pmsg)
+{
+  OS_EVENT* pevent = os_event_create(OS_EVENT_TYPE_MBOX);
+
+  if (pevent)
+    pevent->OSEventPtr = pmsg;
+  return pevent;
+}
+
+void* OSMboxPend(OS_EVENT* pevent, INT16U timeout, INT8U* perr)
+{
+  void* msg;
+
+  if (!pevent) { *perr = OS_ERR_PEVENT_NULL; return NULL; }
+  if (pevent->OSEventType != OS_EVENT_TYPE_MBOX) { *perr = OS_ERR_EVENT_TYPE; return NULL; }
+
+  os_lock();
+  if (OSIntNesting || !os_self) {
+    os_unlock();
+    *perr = OS_ERR_PEND_ISR;
+    return NULL;
+  }
+  if ((msg = pevent->OSEventPtr) != NULL) {
+    pevent->OSEventPtr = NULL;
+    *perr = OS_ERR_NONE;
+    os_exit();
+    return msg;
+  }
+  os_pend(OS_STAT_MBOX, pevent, timeout);
+  if (os_self->pend_to) {
+    msg = NULL;
+    *perr = OS_ERR_TIMEOUT;
+  } else {
+    msg = os_self->msg;
+    *perr = OS_ERR_NONE;
+  }
+  os_exit();
+  return msg;
+}
+
+void* OSMboxAccept(OS_EVENT* pevent)
+{
+  void* msg;
+
+  if (!pevent || pevent->OSEventType != OS_EVENT_TYPE_MBOX)
+    return NULL;
+  os_lock();
+  msg = pevent->OSEventPtr;
+  pevent->OSEventPtr = NULL;
+  os_unlock();
+  return msg;
+}
+
+INT8U OSMboxPost(OS_EVENT* pevent, void* pmsg)
+{
+  if (!pevent) return OS_ERR_PEVENT_NULL;
+  if (!pmsg) return OS_ERR_POST_NULL_PTR;
+  if (pevent->OSEventType != OS_EVENT_TYPE_MBOX) return OS_ERR_EVENT_TYPE;
+
+  os_lock();
+  if (!os_event_ready(pevent, pmsg, OS_STAT_MBOX)) {
+    if (pevent->OSEventPtr) {
+      os_unlock();
+      return OS_ERR_MBOX_FULL;
+    }
+    pevent->OSEventPtr = pmsg;
+  }
+  os_exit();
+  return OS_ERR_NONE;
+}
+
+/*
+ * Message queues
+ */
+OS_EVENT* OSQCreate(void** start, INT16U size)
+{
+  OS_EVENT* pevent = os_event_create(OS_EVENT_TYPE_Q);
+  OS_Q* q = calloc(1, sizeof(*q));
+
+  if (!pevent || !q) {
+    free(pevent);
+    free(q);
+    return NULL;
+  }
+  q->OSQStart = start;
+  q->OSQEnd = start + size;
+  q->OSQIn = start;
+  q->OSQOut = start;
+  q->OSQSize = size;
+  pevent->OSEventPtr = q;
+  return pevent;
+}
+
+static void* os_q_get(OS_Q* q)
+{
+  void* msg = *q->OSQOut++;
+
+  q->OSQEntries--;
+  if (q->OSQOut == q->OSQEnd)
+    q->OSQOut = q->OSQStart;
+  return msg;
+}
+
+void* OSQPend(OS_EVENT* pevent, INT16U timeout, INT8U* perr)
+{
+  OS_Q* q;
+  void* msg;
+
+  if (!pevent) { *perr = OS_ERR_PEVENT_NULL; return NULL; }
+  if (pevent->OSEventType != OS_EVENT_TYPE_Q) { *perr = OS_ERR_EVENT_TYPE; return NULL; }
+
+  os_lock();
+  if (OSIntNesting || !os_self) {
+    os_unlock();
+    *perr = OS_ERR_PEND_ISR;
+    return NULL;
+  }
+  q = (OS_Q*) pevent->OSEventPtr;
+  if (q->OSQEntries > 0) {
+    msg = os_q_get(q);
+    *perr = OS_ERR_NONE;
+    os_exit();
+    return msg;
+  }
+  os_pend(OS_STAT_Q, pevent, timeout);
+  if (os_self->pend_to) {
+    msg = NULL;
+    *perr = OS_ERR_TIMEOUT;
+  } else {
+    msg = os_self->msg;
+    *perr = OS_ERR_NONE;
+  }
+  os_exit();
+  return msg;
+}
+
+void* OSQAccept(OS_EVENT* pevent, INT8U* perr)
+{
+  OS_Q* q;
+  void* msg = NULL;
+
+  if (!pevent || pevent->OSEventType != OS_EVENT_TYPE_Q) {
+    *perr = OS_ERR_EVENT_TYPE;
+    return NULL;
+  }
+  os_lock();
+  q = (OS_Q*) pevent->OSEventPtr;
+  if (q->OSQEntries > 0) {
+    msg = os_q_get(q);
+    *perr = OS_ERR_NONE;
+  } else {
+    *perr = OS_ERR_Q_EMPTY;
+  }
+  os_unlock();
+  return msg;
+}
+
+INT8U OSQPost(OS_EVENT* pevent, void* pmsg)
+{
+  OS_Q* q;
+
+  if (!pevent) return OS_ERR_PEVENT_NULL;
+  if (pevent->OSEventType != OS_EVENT_TYPE_Q) return OS_ERR_EVENT_TYPE;
+
+  os_lock();
+  if (!os_event_ready(pevent, pmsg, OS_STAT_Q)) {
+    q = (OS_Q*) pevent->OSEventPtr;
+    if (q->OSQEntries >= q->OSQSize) {
+      os_unlock();
+      return OS_ERR_Q_FULL;
+    }
+    *q->OSQIn++ = pmsg;
+    if (q->OSQIn == q->OSQEnd)
+      q->OSQIn = q->OSQStart;
+    q->OSQEntries++;
+  }
+  os_exit();
+  return OS_ERR_NONE;
+}
+
+/*
+ * Memory partitions. They never block, so the kernel lock only guards
+ * the free list.
+ */
+OS_MEM* OSMemCreate(void* addr, INT32U nblks, INT32U blksize, INT8U* perr)
+{
+  OS_MEM* pmem;
+  char* blk = addr;
+  INT32U i;
+
+  if (!addr) { *perr = OS_ERR_MEM_INVALID_ADDR; return NULL; }
+  if (((unsigned long) addr & (sizeof(void*) - 1)) != 0) { *perr = OS_ERR_MEM_INVALID_ADDR; return NULL; }
+  if (nblks < 2) { *perr = OS_ERR_MEM_INVALID_BLKS; return NULL; }
+  if (blksize < sizeof(void*)) { *perr = OS_ERR_MEM_INVALID_SIZE; return NULL; }
+  pmem = calloc(1, sizeof(*pmem));
+  if (!pmem) { *perr = OS_ERR_MEM_INVALID_PART; return NULL; }
+
+  for (i = 0; i + 1 < nblks; ++i, blk += blksize)
+    *(void**) blk = blk + blksize;
+  *(void**) blk = NULL;
+  pmem->OSMemAddr = addr;
+  pmem->OSMemFreeList = addr;
+  pmem->OSMemBlkSize = blksize;
+  pmem->OSMemNBlks = nblks;
+  pmem->OSMemNFree = nblks;
+  *perr = OS_ERR_NONE;
+  return pmem;
+}
+
+void* OSMemGet(OS_MEM* pmem, INT8U* perr)
+{
+  void* blk = NULL;
+
+  if (!pmem) { *perr = OS_ERR_MEM_INVALID_PMEM; return NULL; }
+  os_lock();
+  if (pmem->OSMemNFree > 0) {
+    blk = pmem->OSMemFreeList;
+    pmem->OSMemFreeList = *(void**) blk;
+    pmem->OSMemNFree--;
+    *perr = OS_ERR_NONE;
+  } else {
+    *perr = OS_ERR_MEM_NO_FREE_BLKS;
+  }
+  os_unlock();
+  return blk;
+}
+
+INT8U OSMemPut(OS_MEM* pmem, void* pblk)
+{
+  if (!pmem) return OS_ERR_MEM_INVALID_PMEM;
+  if (!pblk) return OS_ERR_MEM_INVALID_PBLK;
+  os_lock();
+  if (pmem->OSMemNFree >= pmem->OSMemNBlks) {
+    os_unlock();
+    return OS_ERR_MEM_FULL;
+  }
+  *(void**) pblk = pmem->OSMemFreeList;
+  pmem->OSMemFreeList = pblk;
+  pmem->OSMemNFree++;
+  os_unlock();
+  return OS_ERR_NONE;
+}
+
+INT8U OSMemQuery(OS_MEM* pmem, OS_MEM_DATA* p_mem_data)
+{
+  if (!pmem) return OS_ERR_MEM_INVALID_PMEM;
+  if (!p_mem_data) return OS_ERR_MEM_INVALID_PDATA;
+  os_lock();
+  p_mem_data->OSAddr = pmem->OSMemAddr;
+  p_mem_data->OSFreeList = pmem->OSMemFreeList;
+  p_mem_data->OSBlkSize = pmem->OSMemBlkSize;
+  p_mem_data->OSNBlks = pmem->OSMemNBlks;
+  p_mem_data->OSNFree = pmem->OSMemNFree;
+  p_mem_data->OSNUsed = pmem->OSMemNBlks - pmem->OSMemNFree;
+  os_unlock();
+  return OS_ERR_NONE;
+}
+
+/*
+ * Event flags
+ */
+static OS_FLAGS os_flag_match(OS_FLAGS have, OS_FLAGS want, INT8U type)
+{
+  OS_FLAGS rdy;
+
+  switch (type & ~OS_FLAG_CONSUME) {
+  case OS_FLAG_WAIT_SET_ALL: rdy = have & want;  return rdy == want ? rdy : 0;
+  case OS_FLAG_WAIT_SET_ANY: rdy = have & want;  return rdy;
+  case OS_FLAG_WAIT_CLR_ALL: rdy = ~have & want; return rdy == want ? rdy : 0;
+  case OS_FLAG_WAIT_CLR_ANY: rdy = ~have & want; return rdy;
+  }
+  return 0;
+}
+
+static void os_flag_consume(OS_FLAG_GRP* pgrp, OS_FLAGS rdy, INT8U type)
+{
+  if (!(type & OS_FLAG_CONSUME))
+    return;
+  if ((type & ~OS_FLAG_CONSUME) >= OS_FLAG_WAIT_SET_ALL)
+    pgrp->OSFlagFlags &= ~rdy;
+  else
+    pgrp->OSFlagFlags |= rdy;
+}
+
+OS_FLAG_GRP* OSFlagCreate(OS_FLAGS flags, INT8U* perr)
+{
+  OS_FLAG_GRP* pgrp = calloc(1, sizeof(*pgrp));
+
+  if (!pgrp) {
+    *perr = OS_ERR_FLAG_GRP_DEPLETED;
+    return NULL;
+  }
+  pgrp->OSFlagType = OS_EVENT_TYPE_FLAG;
+  pgrp->OSFlagFlags = flags;
+  *perr = OS_ERR_NONE;
+  return pgrp;
+}
+
+OS_FLAGS OSFlagPend(OS_FLAG_GRP* pgrp, OS_FLAGS flags, INT8U wait_type, INT16U timeout, INT8U* perr)
+{
+  OS_TCB* self = os_self;
+  OS_FLAGS rdy;
+
+  if (!pgrp) { *perr = OS_ERR_PEVENT_NULL; return 0; }
+  if ((wait_type & ~OS_FLAG_CONSUME) > OS_FLAG_WAIT_SET_ANY) { *perr = OS_ERR_FLAG_WAIT_TYPE; return 0; }
+
+  os_lock();
+  if (OSIntNesting || !self) {
+    os_unlock();
+    *perr = OS_ERR_PEND_ISR;
+    return 0;
+  }
+  if ((rdy = os_flag_match(pgrp->OSFlagFlags, flags, wait_type)) != 0) {
+    os_flag_consume(pgrp, rdy, wait_type);
+    *perr = OS_ERR_NONE;
+    os_exit();
+    return rdy;
+  }
+  self->flag_grp = pgrp;
+  self->flag_wait = flags;
+  self->flag_type = wait_type;
+  self->flag_rdy = 0;
+  os_pend(OS_STAT_FLAG, NULL, timeout);
+  self->flag_grp = NULL;
+  if (self->pend_to) {
+    rdy = 0;
+    *perr = OS_ERR_TIMEOUT;
+  } else {
+    rdy = self->flag_rdy;
+    *perr = OS_ERR_NONE;
+  }
+  os_exit();
+  return rdy;
+}
+
+OS_FLAGS OSFlagAccept(OS_FLAG_GRP* pgrp, OS_FLAGS flags, INT8U wait_type, INT8U* perr)
+{
+  OS_FLAGS rdy;
+
+  if (!pgrp) { *perr = OS_ERR_PEVENT_NULL; return 0; }
+  os_lock();
+  if ((rdy = os_flag_match(pgrp->OSFlagFlags, flags, wait_type)) != 0) {
+    os_flag_consume(pgrp, rdy, wait_type);
+    *perr = OS_ERR_NONE;
+  } else {
+    *perr = OS_ERR_FLAG_NOT_RDY;
+  }
+  os_unlock();
+  return rdy;
+}
+
+OS_FLAGS OSFlagPost(OS_FLAG_GRP* pgrp, OS_FLAGS flags, INT8U opt, INT8U* perr)
+{
+  OS_FLAGS rdy, result;
+  OS_TCB* t;
+  int p;
+
+  if (!pgrp) { *perr = OS_ERR_PEVENT_NULL; return 0; }
+
+  os_lock();
+  if (opt == OS_FLAG_SET)
+    pgrp->OSFlagFlags |= flags;
+  else
+    pgrp->OSFlagFlags &= ~flags;
+
+  /* one scan readies every task whose condition is now met */
+  for (p = 0; p <= OS_LOWEST_PRIO; ++p) {
+    t = OSTCBPrioTbl[p];
+    if (!t || !(t->stat & OS_STAT_FLAG) || t->flag_grp != pgrp)
+      continue;
+    if ((rdy = os_flag_match(pgrp->OSFlagFlags, t->flag_wait, t->flag_type)) != 0) {
+      os_flag_consume(pgrp, rdy, t->flag_type);
+      t->flag_rdy = rdy;
+      t->stat &= ~OS_STAT_FLAG;
+      t->dly = 0;
+    }
+  }
+  result = pgrp->OSFlagFlags;
+  *perr = OS_ERR_NONE;
+  os_exit();
+  return result;
+}
+
+OS_FLAGS OSFlagQuery(OS_FLAG_GRP* pgrp, INT8U* perr)
+{
+  OS_FLAGS flags;
+
+  if (!pgrp) { *perr = OS_ERR_PEVENT_NULL; return 0; }
+  os_lock();
+  flags = pgrp->OSFlagFlags;
+  os_unlock();
+  *perr = OS_ERR_NONE;
+  return flags;
+}
+
+/*
+ * Timers, run by the timer task
+ */
+static OS_EVENT* os_tmr_sem;
+static OS_TMR*   os_tmr_list;
+static INT32U    os_tmr_time;
+
+OS_TMR* OSTmrCreate(INT32U dly, INT32U period, INT8U opt, OS_TMR_CALLBACK callback,
+                    void* callback_arg, INT8U* pname, INT8U* perr)
+{
+  OS_TMR* ptmr;
+
+  if (opt == OS_TMR_OPT_PERIODIC && period == 0) { *perr = OS_ERR_TMR_INVALID_PERIOD; return NULL; }
+  if (opt == OS_TMR_OPT_ONE_SHOT && dly == 0) { *perr = OS_ERR_TMR_INVALID_DLY; return NULL; }
+  if (opt != OS_TMR_OPT_PERIODIC && opt != OS_TMR_OPT_ONE_SHOT) { *perr = OS_ERR_TMR_INVALID_OPT; return NULL; }
+  if (!(ptmr = calloc(1, sizeof(*ptmr)))) { *perr = OS_ERR_TMR_NON_AVAIL; return NULL; }
+
+  ptmr->OSTmrCallback = callback;
+  ptmr->OSTmrCallbackArg = callback_arg;
+  ptmr->OSTmrDly = dly;
+  ptmr->OSTmrPeriod = period;
+  ptmr->OSTmrName = pname;
+  ptmr->OSTmrOpt = opt;
+  ptmr->OSTmrState = OS_TMR_STATE_STOPPED;
+
+  os_lock();
+  ptmr->OSTmrNext = os_tmr_list;
+  os_tmr_list = ptmr;
+  os_unlock();
+  *perr = OS_ERR_NONE;
+  return ptmr;
+}
+
+BOOLEAN OSTmrStart(OS_TMR* ptmr, INT8U* perr)
+{
+  if (!ptmr) { *perr = OS_ERR_TMR_INVALID; return FALSE; }
+  os_lock();
+  ptmr->OSTmrMatch = os_tmr_time + (ptmr->OSTmrDly ? ptmr->OSTmrDly : ptmr->OSTmrPeriod);
+  ptmr->OSTmrState = OS_TMR_STATE_RUNNING;
+  os_unlock();
+  *perr = OS_ERR_NONE;
+  return TRUE;
+}
+
+BOOLEAN OSTmrStop(OS_TMR* ptmr, INT8U opt, void* callback_arg, INT8U* perr)
+{
+  (void) opt; (void) callback_arg;
+  if (!ptmr) { *perr = OS_ERR_TMR_INVALID; return FALSE; }
+  os_lock();
+  ptmr->OSTmrState = OS_TMR_STATE_STOPPED;
+  os_unlock();
+  *perr = OS_ERR_NONE;
+  return TRUE;
+}
+
+INT8U OSTmrSignal(void)
+{
+  return OSSemPost(os_tmr_sem);
+}
+
+static void os_tmr_task(void* p_arg)
+{
+  OS_TMR* ptmr;
+  INT8U err;
+
+  (void) p_arg;
+  for (;;) {
+    OSSemPend(os_tmr_sem, 0, &err);
+    OSSchedLock();
+    os_lock();
+    os_tmr_time++;
+    for (ptmr = os_tmr_list; ptmr; ptmr = ptmr->OSTmrNext) {
+      if (ptmr->OSTmrState != OS_TMR_STATE_RUNNING || ptmr->OSTmrMatch != os_tmr_time)
+        continue;
+      if (ptmr->OSTmrOpt == OS_TMR_OPT_PERIODIC)
+        ptmr->OSTmrMatch += ptmr->OSTmrPeriod;
+      else
+        ptmr->OSTmrState = OS_TMR_STATE_COMPLETED;
+      if (ptmr->OSTmrCallback) {
+        os_unlock();
+        ptmr->OSTmrCallback(ptmr, ptmr->OSTmrCallbackArg);
+        os_lock();
+      }
+    }
+    os_unlock();
+    OSSchedUnlock();
+  }
+}
+
+/*
+ * Idle and statistics
+ */
+static OS_STK os_idle_stk[1];
+static OS_STK os_tmr_stk[1];
+
+
+static void os_idle_task(void* p_arg)
+{
+  (void) p_arg;
+  for (;;) {
+    os_lock();
+    OSIdleCtr++;
+    os_exit();
+#if OS_APP_HOOKS_EN > 0
+    App_TaskIdleHook();
+#endif
+  }
+}
+
+/*
+ * Measures the idle counts of 100 ms with no other task running, as the
+ * uC/OS-II version does. OSCPUUsage is not computed.
+ */
+void OSStatInit(void)
+{
+  OSTimeDly(2);
+  os_lock();
+  OSIdleCtr = 0;
+  os_unlock();
+  OSTimeDly(OS_TICKS_PER_SEC / 10);
+  os_lock();
+  OSIdleCtrMax = OSIdleCtr;
+  os_stat_rdy = TRUE;
+  os_unlock();
+}
+
+/*
+ * Start-up. Like alt_main() on the board, OSInit() runs before main().
+ */
+__attribute__((constructor))
+void OSInit(void)
+{
+  static BOOLEAN done;
+
+  if (done)
+    return;
+  done = TRUE;
+  os_tmr_sem = OSSemCreate(0);
+  OSTaskCreateExt(os_idle_task, NULL, os_idle_stk, OS_TASK_IDLE_PRIO, OS_TASK_IDLE_PRIO,
+                  os_idle_stk, 1, NULL, OS_TASK_OPT_NONE);
+  OSTaskCreateExt(os_tmr_task, NULL, os_tmr_stk, OS_TASK_TMR_PRIO, OS_TASK_TMR_PRIO,
+                  os_tmr_stk, 1, NULL, OS_TASK_OPT_NONE);
+}
+
+void hal_start(void);
+void hal_stop(void);
+
+/*
+ * Starts the highest priority task and the emulated hardware. With
+ * UCOS_RUN_MS set in the environment the process exits after that many
+ * milliseconds of wall-clock time, otherwise it runs until killed.
+ */
+void OSStart(void)
+{
+  const char* run_ms = getenv("UCOS_RUN_MS");
+
+  hal_start();
+
+  os_lock();
+  OSRunning = TRUE;
+  OSTCBCur = os_highest();
+  OSPrioCur = OSTCBCur->prio;
+  pthread_cond_broadcast(&os_cond);
+  os_unlock();
+
+  if (run_ms) {
+    usleep((useconds_t) strtoul(run_ms, NULL, 0) * 1000);
+    hal_stop();
+    _exit(0);
+  }
+  for (;;)
+    pause();
+}